@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <cmath>
+#include "latency_histogram.hh"
+
+#define SUB_BUCKETS (uint64_t(1) << LATENCY_HISTOGRAM_SUB_BUCKET_BITS)
+
+size_t bucket_index(const uint64_t nanoseconds);
+size_t bucket_index(const uint64_t nanoseconds)
+{
+    if (nanoseconds < SUB_BUCKETS)
+    {
+        return static_cast<size_t>(nanoseconds);
+    }
+    // Position of the most significant bit, at least LATENCY_HISTOGRAM_SUB_BUCKET_BITS here
+    const unsigned int magnitude = 63 - static_cast<unsigned int>(__builtin_clzll(nanoseconds));
+    const unsigned int shift = magnitude - LATENCY_HISTOGRAM_SUB_BUCKET_BITS;
+    return static_cast<size_t>((shift + 1) * SUB_BUCKETS + ((nanoseconds >> shift) - SUB_BUCKETS));
+}
+
+// Largest latency (in nanoseconds) counted in the bucket
+uint64_t highest_equivalent_value(const size_t index);
+uint64_t highest_equivalent_value(const size_t index)
+{
+    if (index < SUB_BUCKETS)
+    {
+        return index;
+    }
+    const uint64_t shift = index / SUB_BUCKETS - 1;
+    const uint64_t lowest = (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    return lowest + ((uint64_t(1) << shift) - 1);
+}
+
+LatencyHistogram::LatencyHistogram():
+    counts_((64 - LATENCY_HISTOGRAM_SUB_BUCKET_BITS) * SUB_BUCKETS, 0), count_(0), sum_(0), max_(0)
+{
+}
+
+void LatencyHistogram::record(const std::chrono::nanoseconds latency)
+{
+    const uint64_t nanoseconds = static_cast<uint64_t>(std::max(latency.count(), std::chrono::nanoseconds::rep(0)));
+    ++counts_[bucket_index(nanoseconds)];
+    ++count_;
+    sum_ += static_cast<double>(nanoseconds);
+    max_ = std::max(max_, nanoseconds);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+    for (size_t index = 0; index < counts_.size(); ++index)
+    {
+        counts_[index] += other.counts_[index];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    max_ = std::max(max_, other.max_);
+}
+
+double LatencyHistogram::mean() const
+{
+    return count_ > 0 ? sum_ / static_cast<double>(count_) * 1e-9 : 0;
+}
+
+double LatencyHistogram::max() const
+{
+    return static_cast<double>(max_) * 1e-9;
+}
+
+double LatencyHistogram::percentile(const double percentile) const
+{
+    if (count_ == 0)
+    {
+        return 0;
+    }
+    const double fraction = std::min(std::max(percentile, 0.), 100.) / 100.;
+    const uint64_t rank = std::max(uint64_t(1), static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(count_))));
+    uint64_t cumulated = 0;
+    for (size_t index = 0; index < counts_.size(); ++index)
+    {
+        cumulated += counts_[index];
+        if (cumulated >= rank)
+        {
+            return static_cast<double>(std::min(highest_equivalent_value(index), max_)) * 1e-9;
+        }
+    }
+    return max();
+}
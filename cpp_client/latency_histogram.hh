@@ -0,0 +1,42 @@
+#ifndef LATENCY_HISTOGRAM_HH
+#define LATENCY_HISTOGRAM_HH
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Each power of two is split into 2^LATENCY_HISTOGRAM_SUB_BUCKET_BITS buckets:
+// the recorded latencies are known to within 1/128 (0.8 %) of their value
+#define LATENCY_HISTOGRAM_SUB_BUCKET_BITS 7
+
+// Distribution of latencies, HdrHistogram style: a latency is counted in a
+// bucket whose width is proportional to its magnitude (log-linear buckets), so
+// any percentile is available from nanoseconds to hours with the same relative
+// precision and a fixed memory footprint (about 60 KiB), whatever the number
+// of recorded latencies. Not thread safe: each thread records its own
+// histogram, and they are merged at the end.
+class LatencyHistogram
+{
+    public:
+        LatencyHistogram();
+
+        void record(const std::chrono::nanoseconds latency);
+        void merge(const LatencyHistogram& other);
+
+        uint64_t count() const {return count_;}
+        // In seconds
+        double mean() const;
+        double max() const;
+        // Smallest latency (in seconds) greater than or equal to percentile % of the recorded ones
+        // (to within the bucket width), 0 if none was recorded
+        double percentile(const double percentile) const;
+
+    private:
+        std::vector<uint64_t> counts_;
+        uint64_t count_;
+        double sum_;        //!< In nanoseconds
+        uint64_t max_;      //!< In nanoseconds
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "load_generator.hh"
+
+using wave::ElevationService;
+
+const char* to_string(const LoadMode mode)
+{
+    switch (mode)
+    {
+        case LoadMode::CLOSED_LOOP:
+            return "closed loop";
+        case LoadMode::OPEN_LOOP:
+            return "open loop";
+    }
+    return "unknown";
+}
+
+LoadOptions::LoadOptions():
+    mode(LoadMode::CLOSED_LOOP), clients(1), rate(0), warmup_requests(10)
+{
+}
+
+LoadResult::LoadResult():
+    requests(0), errors(0), duration(0), latencies()
+{
+}
+
+double LoadResult::throughput() const
+{
+    return duration > 0 ? static_cast<double>(requests - errors) / duration : 0;
+}
+
+std::vector<std::shared_ptr<grpc::Channel> > open_channels(const std::string& target, const size_t number_of_channels)
+{
+    std::vector<std::shared_ptr<grpc::Channel> > channels;
+    for (size_t index = 0; index < std::max(number_of_channels, size_t(1)); ++index)
+    {
+        // Channels with different arguments do not share their connection
+        grpc::ChannelArguments arguments;
+        arguments.SetInt("wave_client.channel_index", static_cast<int>(index));
+        channels.push_back(grpc::CreateCustomChannel(target, grpc::InsecureChannelCredentials(), arguments));
+    }
+    return channels;
+}
+
+LoadResult run_load(const std::vector<std::shared_ptr<grpc::Channel> >& channels, const LoadOptions& options,
+                    const size_t number_of_requests, const LoadClientFactory& make_client)
+{
+    LoadResult result;
+    if (channels.empty())
+    {
+        return result;
+    }
+    const size_t number_of_clients = std::max(options.clients, size_t(1));
+    const bool open_loop = options.mode == LoadMode::OPEN_LOOP && options.rate > 0;
+    std::vector<LatencyHistogram> latencies(number_of_clients);
+    std::vector<size_t> errors(number_of_clients, 0);
+    std::vector<std::chrono::steady_clock::time_point> last_responses(number_of_clients);
+    std::atomic<size_t> next_request(0);
+
+    // The measurement starts once every client is connected and warmed up
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t ready_clients = 0;
+    bool started = false;
+    std::chrono::steady_clock::time_point start;
+
+    std::vector<std::thread> threads;
+    for (size_t client_index = 0; client_index < number_of_clients; ++client_index)
+    {
+        threads.emplace_back([&, client_index]
+        {
+            const std::unique_ptr<ElevationService::Stub> stub = ElevationService::NewStub(channels[client_index % channels.size()]);
+            const LoadClient client = make_client(*stub);
+            for (size_t warmup = 0; warmup < options.warmup_requests; ++warmup)
+            {
+                client(number_of_requests + client_index * options.warmup_requests + warmup);
+            }
+            std::chrono::steady_clock::time_point load_start;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ++ready_clients;
+                changed.notify_all();
+                changed.wait(lock, [&started] {return started;});
+                load_start = start;
+            }
+            last_responses[client_index] = load_start;
+            for (;;)
+            {
+                const size_t index = next_request++;
+                if (index >= number_of_requests)
+                {
+                    break;
+                }
+                std::chrono::steady_clock::time_point sent = std::chrono::steady_clock::now();
+                if (open_loop)
+                {
+                    sent = load_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                            std::chrono::duration<double>(static_cast<double>(index) / options.rate));
+                    std::this_thread::sleep_until(sent);
+                }
+                const grpc::Status status = client(index);
+                const std::chrono::steady_clock::time_point received = std::chrono::steady_clock::now();
+                if (status.ok())
+                {
+                    latencies[client_index].record(received - sent);
+                }
+                else
+                {
+                    ++errors[client_index];
+                }
+                last_responses[client_index] = received;
+            }
+        });
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&ready_clients, number_of_clients] {return ready_clients == number_of_clients;});
+        start = std::chrono::steady_clock::now();
+        started = true;
+    }
+    changed.notify_all();
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    result.requests = number_of_requests;
+    std::chrono::steady_clock::time_point end = start;
+    for (size_t client_index = 0; client_index < number_of_clients; ++client_index)
+    {
+        result.latencies.merge(latencies[client_index]);
+        result.errors += errors[client_index];
+        end = std::max(end, last_responses[client_index]);
+    }
+    result.duration = std::chrono::duration<double>(end - start).count();
+    return result;
+}
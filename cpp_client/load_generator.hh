@@ -0,0 +1,60 @@
+#ifndef LOAD_GENERATOR_HH
+#define LOAD_GENERATOR_HH
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+#include "wave.grpc.pb.h"
+#include "latency_histogram.hh"
+
+enum class LoadMode
+{
+    CLOSED_LOOP,    //!< Each client sends its next request as soon as it gets the previous response
+    OPEN_LOOP       //!< Requests are sent at a fixed rate, whether the previous ones are answered or not
+};
+
+const char* to_string(const LoadMode mode);
+
+struct LoadOptions
+{
+    LoadOptions();
+    LoadMode mode;
+    size_t clients;             //!< Threads making the requests, each with its own stub (and streams)
+    double rate;                //!< OPEN_LOOP only: requests per second, all clients together
+    size_t warmup_requests;     //!< Made by each client before the measurement, not recorded
+};
+
+struct LoadResult
+{
+    LoadResult();
+    double throughput() const;  //!< Successful requests per second
+    size_t requests;
+    size_t errors;
+    double duration;            //!< In seconds, from the first request to the last response
+    LatencyHistogram latencies; //!< Of the successful requests
+};
+
+// One client of a load test: makes the request of the given index and returns its
+// status. It is only called by the thread that created it, so it can keep state
+// between its requests (its own copy of the request, a stream...).
+typedef std::function<grpc::Status(const size_t index)> LoadClient;
+typedef std::function<LoadClient(wave::ElevationService::Stub& stub)> LoadClientFactory;
+
+// Connections to target: gRPC would otherwise share a single connection
+// between the channels created with the same arguments
+std::vector<std::shared_ptr<grpc::Channel> > open_channels(const std::string& target, const size_t number_of_channels);
+
+// Makes number_of_requests requests (of indices 0 to number_of_requests - 1), split across
+// options.clients clients, client i using channels[i % channels.size()].
+//
+// In OPEN_LOOP mode, request i is due at i / options.rate after the start and its
+// latency is measured from that time, not from the time it could actually be sent:
+// when the server cannot keep up, the time the requests spend waiting for a free
+// client is counted (no coordinated omission), and the tail latencies show it.
+LoadResult run_load(const std::vector<std::shared_ptr<grpc::Channel> >& channels, const LoadOptions& options,
+                    const size_t number_of_requests, const LoadClientFactory& make_client);
+
+#endif
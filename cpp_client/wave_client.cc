@@ -1,7 +1,18 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <memory>
+#include <random>
+#include <stdexcept>
 #include <vector>
 #include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <grpcpp/grpcpp.h>
 #include "wave.grpc.pb.h"
 
@@ -10,6 +21,7 @@
 using grpc::Channel;
 using grpc::ClientContext;
 using grpc::ClientReader;
+using grpc::ClientReaderWriter;
 using grpc::Status;
 using wave::Point;
 using wave::ElevationRequest;
@@ -17,7 +29,16 @@ using wave::ElevationResponse;
 using wave::ElevationPoint;
 using wave::ElevationRequestRepeated;
 using wave::ElevationResponseRepeated;
+using wave::ElevationRequestPacked;
+using wave::ElevationResponsePacked;
+using wave::ElevationSessionRequest;
+using wave::ElevationRequestGrid;
+using wave::ElevationRequestSnapshot;
+using wave::ElevationResponseSnapshot;
+using wave::ElevationRequestShared;
+using wave::ElevationResponseShared;
 using wave::ElevationService;
+using wave::PackedEncoding;
 
 void add_points_to_request(ElevationRequest& request, const std::vector<double>& x, const std::vector<double>& y)
 {
@@ -40,13 +61,104 @@ void add_points_to_request_repeated(ElevationRequestRepeated& request, const std
     }
 }
 
+bool is_little_endian();
+bool is_little_endian()
+{
+    const uint16_t one = 1;
+    unsigned char first_byte = 0;
+    std::memcpy(&first_byte, &one, 1);
+    return first_byte == 1;
+}
+
+template <typename T> void pack(const std::vector<double>& values, const size_t size, std::string* bytes)
+{
+    bytes->resize(size * sizeof(T));
+    for (size_t index = 0; index < size; ++index)
+    {
+        const T value = static_cast<T>(values[index]);
+        unsigned char encoded[sizeof(T)];
+        std::memcpy(encoded, &value, sizeof(T));
+        if (not(is_little_endian()))
+        {
+            std::reverse(encoded, encoded + sizeof(T));
+        }
+        std::memcpy(&(*bytes)[index * sizeof(T)], encoded, sizeof(T));
+    }
+}
+
+template <typename T> void unpack(const std::string& bytes, std::vector<double>& values)
+{
+    values.resize(bytes.size() / sizeof(T));
+    for (size_t index = 0; index < values.size(); ++index)
+    {
+        unsigned char encoded[sizeof(T)];
+        std::memcpy(encoded, bytes.data() + index * sizeof(T), sizeof(T));
+        if (not(is_little_endian()))
+        {
+            std::reverse(encoded, encoded + sizeof(T));
+        }
+        T value;
+        std::memcpy(&value, encoded, sizeof(T));
+        values[index] = static_cast<double>(value);
+    }
+}
+
+void add_points_to_request_packed(ElevationRequestPacked& request, const std::vector<double>& x, const std::vector<double>& y,
+                                  const PackedEncoding encoding)
+{
+    const size_t max_size = std::min(x.size(), y.size());
+    request.set_encoding(encoding);
+    if (encoding == wave::FLOAT32)
+    {
+        pack<float>(x, max_size, request.mutable_x());
+        pack<float>(y, max_size, request.mutable_y());
+    }
+    else
+    {
+        pack<double>(x, max_size, request.mutable_x());
+        pack<double>(y, max_size, request.mutable_y());
+    }
+}
+
+void unpack_values(const std::string& bytes, const PackedEncoding encoding, std::vector<double>& values)
+{
+    if (encoding == wave::FLOAT32)
+    {
+        unpack<float>(bytes, values);
+    }
+    else if (is_little_endian())
+    {
+        values.resize(bytes.size() / sizeof(double));
+        if (not(values.empty()))
+        {
+            std::memcpy(values.data(), bytes.data(), values.size() * sizeof(double));
+        }
+    }
+    else
+    {
+        unpack<double>(bytes, values);
+    }
+}
+
+std::vector<double> unpack_values(const std::string& bytes, const PackedEncoding encoding)
+{
+    std::vector<double> values;
+    unpack_values(bytes, encoding, values);
+    return values;
+}
+
 void display_elevations(const ElevationResponse& elevation_response)
 {
     if (elevation_response.elevation_points_size() > 0)
     {
-        for (const ElevationPoint& elevation_point : elevation_response.elevation_points())
+        // Several time steps per message: the points of each of them in turn
+        const int time_steps = std::max(elevation_response.time_steps_size(), 1);
+        const int points_per_time_step = std::max(elevation_response.elevation_points_size() / time_steps, 1);
+        for (int index = 0; index < elevation_response.elevation_points_size(); ++index)
         {
-            std::cout << "ElevationService (x: " << elevation_point.x() << ", y: " << elevation_point.y() << ", t: " << elevation_response.t() <<  ") received: " << elevation_point.z() << std::endl;
+            const ElevationPoint& elevation_point = elevation_response.elevation_points(index);
+            const double t = elevation_response.time_steps_size() > 0 ? elevation_response.time_steps(index / points_per_time_step) : elevation_response.t();
+            std::cout << "ElevationService (x: " << elevation_point.x() << ", y: " << elevation_point.y() << ", t: " << t <<  ") received: " << elevation_point.z() << std::endl;
         }
     }
     else
@@ -61,15 +173,12 @@ ElevationResponse ElevationServiceClient::get_elevation(const ElevationRequest&
     ClientContext context;
 
     Status status = stub_->GetElevation(&context, request, &reply);
-    if (status.ok())
-    {
-        return reply;
-    }
-    else
+    if (not(status.ok()))
     {
         std::cout << status.error_code() << ": " << status.error_message() << std::endl;
         std::cout << "ElevationService failed." << std::endl;
     }
+    return reply;
 }
 
 ElevationResponse ElevationServiceClient::get_elevation_input_repeated(const ElevationRequestRepeated& request)
@@ -78,15 +187,12 @@ ElevationResponse ElevationServiceClient::get_elevation_input_repeated(const Ele
     ClientContext context;
 
     Status status = stub_->GetElevationInputRepeated(&context, request, &reply);
-    if (status.ok())
-    {
-        return reply;
-    }
-    else
+    if (not(status.ok()))
     {
         std::cout << status.error_code() << ": " << status.error_message() << std::endl;
         std::cout << "ElevationService failed." << std::endl;
     }
+    return reply;
 }
 
 ElevationResponseRepeated ElevationServiceClient::get_elevation_output_repeated(const ElevationRequest& request, bool does_return_xy)
@@ -98,36 +204,230 @@ ElevationResponseRepeated ElevationServiceClient::get_elevation_output_repeated(
                     stub_->GetElevationOutputRepeated(&context, request, &reply)
                     :
                     stub_->GetElevationOutputRepeatedZ(&context, request, &reply);
+    if (not(status.ok()))
+    {
+        std::cout << status.error_code() << ": " << status.error_message() << std::endl;
+        std::cout << "ElevationService failed." << std::endl;
+    }
+    return reply;
+}
 
-    if (status.ok())
+SharedPointSegment::SharedPointSegment(const size_t capacity):
+    name_(), token_(0), capacity_(capacity), mapping_(MAP_FAILED), mapping_size_(SHARED_POINTS_HEADER_SIZE + 3 * capacity * sizeof(double)), arrays_(nullptr)
+{
+    // A new name for each segment: the server never maps a removed segment under the name of a new one
+    static std::atomic<unsigned int> next_index(0);
+    name_ = SHARED_POINTS_NAME_PREFIX + std::to_string(getpid()) + "." + std::to_string(next_index++);
+    std::random_device random_device;
+    token_ = (static_cast<uint64_t>(random_device()) << 32) ^ random_device();
+    const int descriptor = shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (descriptor < 0)
     {
-        return reply;
+        throw std::runtime_error("Unable to create the shared memory segment " + name_ + ": " + std::strerror(errno));
     }
-    else
+    if (ftruncate(descriptor, static_cast<off_t>(mapping_size_)) == 0)
     {
-        std::cout << status.error_code() << ": " << status.error_message() << std::endl;
-        std::cout << "ElevationService failed." << std::endl;
+        mapping_ = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    }
+    close(descriptor);
+    if (mapping_ == MAP_FAILED)
+    {
+        shm_unlink(name_.c_str());
+        throw std::runtime_error("Unable to map the shared memory segment " + name_ + ": " + std::strerror(errno));
     }
+    char* bytes = static_cast<char*>(mapping_);
+    const uint64_t capacity_value = capacity;
+    std::memcpy(bytes, SHARED_POINTS_MAGIC, 8);
+    std::memcpy(bytes + 8, &token_, sizeof(token_));
+    std::memcpy(bytes + 16, &capacity_value, sizeof(capacity_value));
+    arrays_ = reinterpret_cast<double*>(bytes + SHARED_POINTS_HEADER_SIZE);
+}
+
+SharedPointSegment::~SharedPointSegment()
+{
+    munmap(mapping_, mapping_size_);
+    shm_unlink(name_.c_str());
+}
+
+bool ElevationServiceClient::get_elevation_shared(const ElevationRequestRepeated& request, ElevationResponseRepeated& reply)
+{
+    const size_t size = static_cast<size_t>(std::min(request.x_size(), request.y_size()));
+    if (size < SHARED_MEMORY_MIN_POINTS)
+    {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(shared_mutex_, std::try_to_lock);
+    if (not(lock.owns_lock()) || not(use_shared_memory_))
+    {
+        return false;
+    }
+    if (not(shared_segment_) || shared_segment_->capacity() < size)
+    {
+        // Grown by powers of two, so that slowly growing requests do not create a segment each
+        size_t capacity = SHARED_MEMORY_MIN_POINTS;
+        while (capacity < size)
+        {
+            capacity *= 2;
+        }
+        shared_segment_.reset();
+        try
+        {
+            shared_segment_.reset(new SharedPointSegment(capacity));
+        }
+        catch (const std::runtime_error&)
+        {
+            use_shared_memory_ = false;
+            return false;
+        }
+    }
+    std::copy(request.x().data(), request.x().data() + size, shared_segment_->x());
+    std::copy(request.y().data(), request.y().data() + size, shared_segment_->y());
+    ElevationRequestShared shared_request;
+    shared_request.set_segment(shared_segment_->name());
+    shared_request.set_token(shared_segment_->token());
+    shared_request.set_number_of_points(size);
+    shared_request.set_t(request.t());
+    ElevationResponseShared shared_reply;
+    ClientContext context;
+
+    Status status = stub_->GetElevationShared(&context, shared_request, &shared_reply);
+    if (not(status.ok()))
+    {
+        // Only the server can tell whether it maps the segment: any other error is reported by the gRPC request
+        if (status.error_code() == grpc::StatusCode::INVALID_ARGUMENT || status.error_code() == grpc::StatusCode::UNIMPLEMENTED)
+        {
+            use_shared_memory_ = false;
+            shared_segment_.reset();
+        }
+        return false;
+    }
+    reply.clear_x(); reply.clear_y();
+    reply.set_t(shared_reply.t());
+    reply.mutable_z()->Resize(static_cast<int>(size), 0.0);
+    std::copy(shared_segment_->z(), shared_segment_->z() + size, reply.mutable_z()->mutable_data());
+    return true;
 }
 
 ElevationResponseRepeated ElevationServiceClient::get_elevation_repeated(const ElevationRequestRepeated& request, bool does_return_xy)
 {
     ElevationResponseRepeated reply;
+    if (not(does_return_xy) && get_elevation_shared(request, reply))
+    {
+        return reply;
+    }
     ClientContext context;
 
     Status status = (does_return_xy) ?
                     stub_->GetElevationRepeated(&context, request, &reply)
                     :
                     stub_->GetElevationRepeatedZ(&context, request, &reply);
-    if (status.ok())
+    if (not(status.ok()))
     {
-        return reply;
+        std::cout << status.error_code() << ": " << status.error_message() << std::endl;
+        std::cout << "ElevationService failed." << std::endl;
     }
-    else
+    return reply;
+}
+
+ElevationResponseRepeatedFloat ElevationServiceClient::get_elevation_repeated_float(const ElevationRequestRepeated& request)
+{
+    ElevationResponseRepeatedFloat reply;
+    ClientContext context;
+
+    Status status = stub_->GetElevationRepeatedFloat(&context, request, &reply);
+    if (not(status.ok()))
     {
         std::cout << status.error_code() << ": " << status.error_message() << std::endl;
         std::cout << "ElevationService failed." << std::endl;
     }
+    return reply;
+}
+
+ElevationResponsePacked ElevationServiceClient::get_elevation_packed(const ElevationRequestPacked& request, bool does_return_xy)
+{
+    ElevationResponsePacked reply;
+    ClientContext context;
+
+    Status status = (does_return_xy) ?
+                    stub_->GetElevationPacked(&context, request, &reply)
+                    :
+                    stub_->GetElevationPackedZ(&context, request, &reply);
+    if (not(status.ok()))
+    {
+        std::cout << status.error_code() << ": " << status.error_message() << std::endl;
+        std::cout << "ElevationService failed." << std::endl;
+    }
+    return reply;
+}
+
+ElevationResponseRepeated ElevationServiceClient::get_elevation_grid(const ElevationRequestGrid& request)
+{
+    ElevationResponseRepeated reply;
+    ClientContext context;
+
+    Status status = stub_->GetElevationGrid(&context, request, &reply);
+    if (not(status.ok()))
+    {
+        std::cout << status.error_code() << ": " << status.error_message() << std::endl;
+        std::cout << "ElevationService failed." << std::endl;
+    }
+    return reply;
+}
+
+ElevationResponseSnapshot ElevationServiceClient::get_elevation_snapshot(const ElevationRequestSnapshot& request)
+{
+    ElevationResponseSnapshot reply;
+    ClientContext context;
+
+    Status status = stub_->GetElevationSnapshot(&context, request, &reply);
+    if (not(status.ok()))
+    {
+        std::cout << status.error_code() << ": " << status.error_message() << std::endl;
+        std::cout << "ElevationService failed." << std::endl;
+    }
+    return reply;
+}
+
+ElevationResponseTimes ElevationServiceClient::get_elevation_times(const ElevationRequestTimes& request)
+{
+    ElevationResponseTimes reply;
+    ClientContext context;
+
+    Status status = stub_->GetElevationTimes(&context, request, &reply);
+    if (not(status.ok()))
+    {
+        std::cout << status.error_code() << ": " << status.error_message() << std::endl;
+        std::cout << "ElevationService failed." << std::endl;
+    }
+    return reply;
+}
+
+SetWaveSpectrumResponse ElevationServiceClient::set_wave_spectrum(const SetWaveSpectrumRequest& request)
+{
+    SetWaveSpectrumResponse reply;
+    ClientContext context;
+
+    Status status = stub_->SetWaveSpectrum(&context, request, &reply);
+    if (not(status.ok()))
+    {
+        std::cout << status.error_code() << ": " << status.error_message() << std::endl;
+        std::cout << "ElevationService failed." << std::endl;
+    }
+    return reply;
+}
+
+ServerStatsResponse ElevationServiceClient::get_server_stats()
+{
+    ServerStatsResponse reply;
+    ClientContext context;
+
+    Status status = stub_->GetServerStats(&context, wave::ServerStatsRequest(), &reply);
+    if (not(status.ok()))
+    {
+        std::cout << status.error_code() << ": " << status.error_message() << std::endl;
+        std::cout << "ElevationService failed." << std::endl;
+    }
+    return reply;
 }
 
 void ElevationServiceClient::get_elevations(const std::vector<double>& x, const std::vector<double>& y,
@@ -155,3 +455,170 @@ void ElevationServiceClient::get_elevations(const std::vector<double>& x, const
         std::cout << "ElevationService failed." << std::endl;
     }
 }
+
+std::vector<ElevationResponse> ElevationServiceClient::get_elevations(const ElevationRequest& request)
+{
+    std::vector<ElevationResponse> responses;
+    ElevationResponse elevationResponse;
+    ClientContext context;
+
+    std::unique_ptr<ClientReader<ElevationResponse> > reader(stub_->GetElevations(&context, request));
+    while (reader->Read(&elevationResponse))
+    {
+        responses.push_back(elevationResponse);
+    }
+    Status status = reader->Finish();
+
+    if (not(status.ok()))
+    {
+        std::cout << status.error_code() << ": " << status.error_message() << std::endl;
+        std::cout << "ElevationService failed." << std::endl;
+        responses.clear();
+    }
+    return responses;
+}
+
+std::unique_ptr<ElevationSessionClient> ElevationServiceClient::start_session(const std::vector<double>& x, const std::vector<double>& y)
+{
+    return std::unique_ptr<ElevationSessionClient>(new ElevationSessionClient(*stub_, x, y));
+}
+
+ElevationSessionClient::ElevationSessionClient(ElevationService::Stub& stub, const std::vector<double>& x, const std::vector<double>& y):
+    context_(), stream_(), x_(x), y_(y), has_sent_points_(false), request_(), reply_()
+{
+    stream_ = stub.ElevationSession(&context_);
+}
+
+bool ElevationSessionClient::get_elevations(const double t, std::vector<double>& z)
+{
+    request_.Clear();
+    request_.set_t(t);
+    return exchange(request_, z);
+}
+
+bool ElevationSessionClient::move_points(const std::vector<double>& dx, const std::vector<double>& dy, const double t, std::vector<double>& z)
+{
+    request_.Clear();
+    const size_t max_size = std::min(dx.size(), dy.size());
+    for (size_t index = 0; index < max_size; ++index)
+    {
+        request_.add_dx(dx[index]);
+        request_.add_dy(dy[index]);
+    }
+    request_.set_t(t);
+    return exchange(request_, z);
+}
+
+bool ElevationSessionClient::exchange(ElevationSessionRequest& request, std::vector<double>& z)
+{
+    if (not(has_sent_points_))
+    {
+        const size_t max_size = std::min(x_.size(), y_.size());
+        for (size_t index = 0; index < max_size; ++index)
+        {
+            request.add_x(x_[index]);
+            request.add_y(y_[index]);
+        }
+    }
+    if (not(stream_->Write(request)) || not(stream_->Read(&reply_)))
+    {
+        return false;
+    }
+    has_sent_points_ = true;
+    z.assign(reply_.z().begin(), reply_.z().end());
+    return true;
+}
+
+Status ElevationSessionClient::finish()
+{
+    stream_->WritesDone();
+    return stream_->Finish();
+}
+
+ElevationServiceError::ElevationServiceError(const Status& status):
+    std::runtime_error("ElevationService failed (" + std::to_string(status.error_code()) + "): " + status.error_message()), code_(status.error_code())
+{
+}
+
+AsyncElevationServiceClient::AsyncElevationServiceClient(const std::shared_ptr<Channel>& channel, const size_t max_in_flight):
+    stub_(ElevationService::NewStub(channel)), queue_(), max_in_flight_(std::max(max_in_flight, size_t(1))), mutex_(), answered_(), in_flight_(0),
+    polling_thread_()
+{
+    polling_thread_ = std::thread([this] {poll();});
+}
+
+AsyncElevationServiceClient::~AsyncElevationServiceClient()
+{
+    wait();
+    queue_.Shutdown();
+    polling_thread_.join();
+}
+
+std::future<ElevationResponseRepeated> AsyncElevationServiceClient::get_elevation_repeated(const ElevationRequestRepeated& request, const bool does_return_xy)
+{
+    return start(does_return_xy ? &ElevationService::Stub::PrepareAsyncGetElevationRepeated : &ElevationService::Stub::PrepareAsyncGetElevationRepeatedZ,
+                 request);
+}
+
+std::future<ElevationResponsePacked> AsyncElevationServiceClient::get_elevation_packed(const ElevationRequestPacked& request, const bool does_return_xy)
+{
+    return start(does_return_xy ? &ElevationService::Stub::PrepareAsyncGetElevationPacked : &ElevationService::Stub::PrepareAsyncGetElevationPackedZ,
+                 request);
+}
+
+std::future<ElevationResponseRepeated> AsyncElevationServiceClient::get_elevation_grid(const ElevationRequestGrid& request)
+{
+    return start(&ElevationService::Stub::PrepareAsyncGetElevationGrid, request);
+}
+
+std::future<ElevationResponseTimes> AsyncElevationServiceClient::get_elevation_times(const ElevationRequestTimes& request)
+{
+    return start(&ElevationService::Stub::PrepareAsyncGetElevationTimes, request);
+}
+
+size_t AsyncElevationServiceClient::in_flight() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return in_flight_;
+}
+
+void AsyncElevationServiceClient::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    answered_.wait(lock, [this] {return in_flight_ == 0;});
+}
+
+void AsyncElevationServiceClient::acquire_slot()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    answered_.wait(lock, [this] {return in_flight_ < max_in_flight_;});
+    ++in_flight_;
+}
+
+void AsyncElevationServiceClient::poll()
+{
+    void* tag = nullptr;
+    bool ok = false;
+    while (queue_.Next(&tag, &ok))
+    {
+        // Finish always completes (ok is true), the status telling whether the request succeeded
+        const std::unique_ptr<AsyncClientCall> call(static_cast<AsyncClientCall*>(tag));
+        try
+        {
+            call->complete();
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "A callback of AsyncElevationServiceClient threw: " << e.what() << std::endl;
+        }
+        catch (...)
+        {
+            std::cerr << "A callback of AsyncElevationServiceClient threw." << std::endl;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --in_flight_;
+        }
+        answered_.notify_all();
+    }
+}
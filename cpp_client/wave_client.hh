@@ -1,3 +1,12 @@
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
 #include <grpcpp/grpcpp.h>
 #include "wave.grpc.pb.h"
@@ -7,24 +16,236 @@ using wave::ElevationRequest;
 using wave::ElevationResponse;
 using wave::ElevationRequestRepeated;
 using wave::ElevationResponseRepeated;
+using wave::ElevationResponseRepeatedFloat;
+using wave::ElevationRequestPacked;
+using wave::ElevationResponsePacked;
+using wave::ElevationSessionRequest;
+using wave::ElevationRequestGrid;
+using wave::ElevationRequestSnapshot;
+using wave::ElevationResponseSnapshot;
+using wave::ElevationRequestTimes;
+using wave::ElevationResponseTimes;
+using wave::SetWaveSpectrumRequest;
+using wave::SetWaveSpectrumResponse;
+using wave::ServerStatsResponse;
 using wave::ElevationService;
+using wave::PackedEncoding;
 
 void add_points_to_request(ElevationRequest& request, const std::vector<double>& x, const std::vector<double>& y);
 void add_points_to_request_repeated(ElevationRequestRepeated& request, const std::vector<double>& x, const std::vector<double>& y);
+void add_points_to_request_packed(ElevationRequestPacked& request, const std::vector<double>& x, const std::vector<double>& y,
+                                  const PackedEncoding encoding = wave::FLOAT64);
+// Decodes a packed field (e.g. ElevationResponsePacked::z) into values, reusing its storage.
+// Little-endian doubles are copied in one block, without any per-element decoding.
+void unpack_values(const std::string& bytes, const PackedEncoding encoding, std::vector<double>& values);
+std::vector<double> unpack_values(const std::string& bytes, const PackedEncoding encoding);
 
 void display_elevations(const ElevationResponse& elevation_response);
 
+// Requests of at least SHARED_MEMORY_MIN_POINTS points go through shared memory when the server can map it
+#define SHARED_MEMORY_MIN_POINTS 4096
+// Segment layout, see ElevationRequestShared
+#define SHARED_POINTS_MAGIC "WAVESHM1"
+#define SHARED_POINTS_HEADER_SIZE 64
+#define SHARED_POINTS_NAME_PREFIX "/wave_client."
+
+// Client side of GetElevationShared: a POSIX shared memory segment holding x, y and z,
+// capacity doubles each, named after the process. The segment is removed by the destructor.
+class SharedPointSegment
+{
+    public:
+        // Throws std::runtime_error if the segment cannot be created
+        explicit SharedPointSegment(const size_t capacity);
+        SharedPointSegment(const SharedPointSegment&) = delete;
+        SharedPointSegment& operator=(const SharedPointSegment&) = delete;
+        ~SharedPointSegment();
+        const std::string& name() const {return name_;}
+        uint64_t token() const {return token_;}
+        size_t capacity() const {return capacity_;}
+        double* x() {return arrays_;}
+        double* y() {return arrays_ + capacity_;}
+        const double* z() const {return arrays_ + 2 * capacity_;}
+    private:
+        std::string name_;
+        uint64_t token_;
+        size_t capacity_;
+        void* mapping_;
+        size_t mapping_size_;
+        double* arrays_;
+};
+
+// Client side of an ElevationSession stream: the point set is only sent with
+// the first message, the following ones just carry t (and optional displacements).
+class ElevationSessionClient
+{
+    public:
+        ElevationSessionClient(ElevationService::Stub& stub, const std::vector<double>& x, const std::vector<double>& y);
+        // Elevations of the point set at t. Returns false if the stream is broken: see finish() for the reason.
+        bool get_elevations(const double t, std::vector<double>& z);
+        // Moves each point of the set by (dx, dy), then gets the elevations at t.
+        bool move_points(const std::vector<double>& dx, const std::vector<double>& dy, const double t, std::vector<double>& z);
+        grpc::Status finish();
+    private:
+        bool exchange(ElevationSessionRequest& request, std::vector<double>& z);
+        grpc::ClientContext context_;
+        std::unique_ptr<grpc::ClientReaderWriter<ElevationSessionRequest, ElevationResponseRepeated> > stream_;
+        std::vector<double> x_;
+        std::vector<double> y_;
+        bool has_sent_points_;
+        ElevationSessionRequest request_;
+        ElevationResponseRepeated reply_;
+};
+
 class ElevationServiceClient
 {
     public:
         ElevationServiceClient(const std::shared_ptr<Channel>& channel)
-            : stub_(ElevationService::NewStub(channel)) {}
+            : stub_(ElevationService::NewStub(channel)), shared_mutex_(), shared_segment_(), use_shared_memory_(true) {}
         ElevationResponse get_elevation(const ElevationRequest& resquest);
         ElevationResponse get_elevation_input_repeated(const ElevationRequestRepeated& resquest);
         ElevationResponseRepeated get_elevation_output_repeated(const ElevationRequest& resquest, bool does_return_xy);
+        // Without x and y, large requests are sent through shared memory if the server is on the same host (see get_elevation_shared)
         ElevationResponseRepeated get_elevation_repeated(const ElevationRequestRepeated& resquest, bool does_return_xy);
+        // z only, computed in single precision
+        ElevationResponseRepeatedFloat get_elevation_repeated_float(const ElevationRequestRepeated& request);
+        ElevationResponsePacked get_elevation_packed(const ElevationRequestPacked& resquest, bool does_return_xy);
+        ElevationResponseRepeated get_elevation_grid(const ElevationRequestGrid& resquest);
+        ElevationResponseSnapshot get_elevation_snapshot(const ElevationRequestSnapshot& resquest);
+        // The points of request at all its times, in a single response
+        ElevationResponseTimes get_elevation_times(const ElevationRequestTimes& request);
+        // Replaces the wave spectrum of the server, for all its clients
+        SetWaveSpectrumResponse set_wave_spectrum(const SetWaveSpectrumRequest& request);
+        // What the server recorded about the requests it served (see ServerStatsResponse)
+        ServerStatsResponse get_server_stats();
         void get_elevations(const std::vector<double>& x, const std::vector<double>& y,
                             const double dt, const double t_start, const double t_end);
+        // All the messages of the GetElevations stream of request (empty if it failed)
+        std::vector<ElevationResponse> get_elevations(const ElevationRequest& request);
+        std::unique_ptr<ElevationSessionClient> start_session(const std::vector<double>& x, const std::vector<double>& y);
     private:
+        // GetElevationShared with the points of request, copied into the segment of this client. Returns false if the
+        // request should be sent over gRPC instead: too small, segment busy (used by another thread) or shared memory
+        // not available. Shared memory is given up for good once the server could not map the segment (other host or
+        // container, older server...).
+        bool get_elevation_shared(const ElevationRequestRepeated& request, ElevationResponseRepeated& reply);
         std::unique_ptr<ElevationService::Stub> stub_;
-};
\ No newline at end of file
+        std::mutex shared_mutex_;   //!< Protects shared_segment_ and use_shared_memory_
+        std::unique_ptr<SharedPointSegment> shared_segment_;
+        bool use_shared_memory_;
+};
+
+// Failed request of AsyncElevationServiceClient, thrown by the futures
+class ElevationServiceError : public std::runtime_error
+{
+    public:
+        explicit ElevationServiceError(const grpc::Status& status);
+        grpc::StatusCode code() const {return code_;}
+    private:
+        grpc::StatusCode code_;
+};
+
+// One request of AsyncElevationServiceClient, used as the completion queue tag
+class AsyncClientCall
+{
+    public:
+        virtual ~AsyncClientCall() {}
+        virtual void complete() = 0;    //!< Calls the callback with the status and response
+        grpc::ClientContext context;
+        grpc::Status status;
+};
+
+template <typename Response>
+class AsyncClientResponse final : public AsyncClientCall
+{
+    public:
+        typedef std::function<void(const grpc::Status& status, Response& response)> Callback;
+        explicit AsyncClientResponse(const Callback& callback) : response(), reader(), callback_(callback) {}
+        void complete() override {callback_(status, response);}
+        Response response;
+        std::unique_ptr<grpc::ClientAsyncResponseReader<Response> > reader;
+    private:
+        Callback callback_;
+};
+
+// Non-blocking client: each request returns at once, with a future or by calling a callback
+// once the response is received, so that a solver can send the request of its next time step
+// and keep computing while the server answers. All the requests share one channel and one
+// completion queue, polled by a thread of the client, which calls the callbacks and fulfils
+// the futures.
+//
+// At most max_in_flight requests are sent and not answered yet: beyond, a new request waits
+// (in the calling thread) for the oldest ones to be answered. Failed requests are reported with
+// their status: the futures throw ElevationServiceError, the callbacks get the status.
+class AsyncElevationServiceClient
+{
+    public:
+        template <typename Request, typename Response>
+        using PrepareMethod = std::unique_ptr<grpc::ClientAsyncResponseReader<Response> > (ElevationService::Stub::*)(
+                                  grpc::ClientContext*, const Request&, grpc::CompletionQueue*);
+
+        explicit AsyncElevationServiceClient(const std::shared_ptr<Channel>& channel, const size_t max_in_flight = 8);
+        AsyncElevationServiceClient(const AsyncElevationServiceClient&) = delete;
+        AsyncElevationServiceClient& operator=(const AsyncElevationServiceClient&) = delete;
+        // Waits for the requests in flight
+        ~AsyncElevationServiceClient();
+
+        std::future<ElevationResponseRepeated> get_elevation_repeated(const ElevationRequestRepeated& request, const bool does_return_xy);
+        std::future<ElevationResponsePacked> get_elevation_packed(const ElevationRequestPacked& request, const bool does_return_xy);
+        std::future<ElevationResponseRepeated> get_elevation_grid(const ElevationRequestGrid& request);
+        std::future<ElevationResponseTimes> get_elevation_times(const ElevationRequestTimes& request);
+
+        // Any unary RPC, e.g. start(&ElevationService::Stub::PrepareAsyncGetElevationRepeatedZ, request, callback).
+        // The callback is called by the polling thread: it should be short, and must not wait for
+        // another request of this client (which could need its slot in the window). An exception
+        // thrown by the callback is written to std::cerr and does not stop the polling thread.
+        template <typename Request, typename Response>
+        void start(const PrepareMethod<Request, Response> prepare, const Request& request,
+                   const typename AsyncClientResponse<Response>::Callback& callback);
+        template <typename Request, typename Response>
+        std::future<Response> start(const PrepareMethod<Request, Response> prepare, const Request& request);
+
+        size_t in_flight() const;
+        void wait();    //!< Until every request sent so far is answered
+
+    private:
+        void acquire_slot();
+        void poll();
+
+        std::unique_ptr<ElevationService::Stub> stub_;
+        grpc::CompletionQueue queue_;
+        const size_t max_in_flight_;
+        mutable std::mutex mutex_;
+        std::condition_variable answered_;
+        size_t in_flight_;
+        std::thread polling_thread_;
+};
+
+template <typename Request, typename Response>
+void AsyncElevationServiceClient::start(const PrepareMethod<Request, Response> prepare, const Request& request,
+                                        const typename AsyncClientResponse<Response>::Callback& callback)
+{
+    acquire_slot();
+    AsyncClientResponse<Response>* call = new AsyncClientResponse<Response>(callback);
+    call->reader = ((*stub_).*prepare)(&call->context, request, &queue_);
+    call->reader->StartCall();
+    // Deleted by poll(), once the response is received
+    call->reader->Finish(&call->response, &call->status, call);
+}
+
+template <typename Request, typename Response>
+std::future<Response> AsyncElevationServiceClient::start(const PrepareMethod<Request, Response> prepare, const Request& request)
+{
+    const std::shared_ptr<std::promise<Response> > promise = std::make_shared<std::promise<Response> >();
+    start(prepare, request, typename AsyncClientResponse<Response>::Callback([promise](const grpc::Status& status, Response& response)
+    {
+        if (status.ok())
+        {
+            promise->set_value(std::move(response));
+        }
+        else
+        {
+            promise->set_exception(std::make_exception_ptr(ElevationServiceError(status)));
+        }
+    }));
+    return promise->get_future();
+}
@@ -1,153 +1,420 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <memory>
+#include <random>
+#include <sstream>
 #include <vector>
 #include <string>
-#include <chrono>
 #include <grpcpp/grpcpp.h>
 #include "args.hxx"
+#include "load_generator.hh"
 #include "wave_client.hh"
 
+using grpc::ClientContext;
+using grpc::Status;
 using wave::ElevationRequest;
 using wave::ElevationRequestRepeated;
+using wave::ElevationRequestPacked;
 
-double test_unary_elevation(size_t vector_size, size_t loop_size, ElevationServiceClient& elevation_service)
+std::string add_spaces(size_t size)
 {
-    // Data
-    const std::vector<double> x(vector_size, 1.3);
-    const std::vector<double> y(vector_size, 2.7);
-    const double t(0.1);
-    auto start = std::chrono::system_clock::now();
-    std::chrono::duration<double> diff = start-start;
+    return (size < 10 ? "     " :
+           (size < 100 ? "    " :
+           (size < 1000 ? "   " :
+           (size < 10000 ? "  " :
+           (size < 100000 ? " " :
+            "" )))));
+}
 
-    ElevationRequest request;
-    add_points_to_request(request, x, y);
-    request.set_t(t);
+// Each client cycles through this many point sets (of the same size)
+#define POINT_SETS_PER_RUN 8
+// GetElevationTimes requests
+#define TIMES_PER_REQUEST 10
+#define TIMES_DT 0.1
+// GetElevations streams
+#define STREAM_TIME_STEPS 10
+#define STREAM_DT 0.1
+
+struct BenchmarkResult
+{
+    std::string rpc;
+    size_t points;
+    LoadResult load;
+};
+
+// t of the request of the given index: never twice the same, so that no request is answered from the server's cache
+double request_time(const size_t index);
+double request_time(const size_t index)
+{
+    return 0.1 + 1e-3 * static_cast<double>(index);
+}
 
-    // Compute average time response for requesting elevation
-    for (size_t ind = 0; ind < loop_size; ++ind)
+// Points spread over a 1 km square, a different set for each seed
+void random_points(const size_t number_of_points, const unsigned int seed, std::vector<double>& x, std::vector<double>& y);
+void random_points(const size_t number_of_points, const unsigned int seed, std::vector<double>& x, std::vector<double>& y)
+{
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> coordinate(-500., 500.);
+    x.resize(number_of_points);
+    y.resize(number_of_points);
+    for (size_t index = 0; index < number_of_points; ++index)
     {
-        start = std::chrono::system_clock::now();
-        elevation_service.get_elevation(request);
-        diff += std::chrono::system_clock::now() - start;
+        x[index] = coordinate(generator);
+        y[index] = coordinate(generator);
     }
-    return diff.count() * 1000 / loop_size;
 }
 
-double test_input_repeated_unary_elevation(size_t vector_size, size_t loop_size, ElevationServiceClient& elevation_service)
+void set_request_time(ElevationRequest& request, const double t);
+void set_request_time(ElevationRequest& request, const double t)
 {
-    // Data
-    const std::vector<double> x(vector_size, 1.3);
-    const std::vector<double> y(vector_size, 2.7);
-    const double t(0.1);
-    auto start = std::chrono::system_clock::now();
-    std::chrono::duration<double> diff = start-start;
+    request.set_t(t);
+}
 
-    ElevationRequestRepeated request;
-    add_points_to_request_repeated(request, x, y);
+void set_request_time(ElevationRequestRepeated& request, const double t);
+void set_request_time(ElevationRequestRepeated& request, const double t)
+{
+    request.set_t(t);
+}
+
+void set_request_time(ElevationRequestPacked& request, const double t);
+void set_request_time(ElevationRequestPacked& request, const double t)
+{
+    request.set_t(t);
+}
+
+void set_request_time(ElevationRequestGrid& request, const double t);
+void set_request_time(ElevationRequestGrid& request, const double t)
+{
     request.set_t(t);
+}
+
+void set_request_time(ElevationRequestSnapshot& request, const double t);
+void set_request_time(ElevationRequestSnapshot& request, const double t)
+{
+    request.mutable_grid()->set_t(t);
+}
 
-    // Compute average time response for requesting elevation
-    for (size_t ind = 0; ind < loop_size; ++ind)
+void set_request_time(ElevationRequestTimes& request, const double t);
+void set_request_time(ElevationRequestTimes& request, const double t)
+{
+    request.clear_t();
+    for (size_t index = 0; index < TIMES_PER_REQUEST; ++index)
     {
-        start = std::chrono::system_clock::now();
-        elevation_service.get_elevation_input_repeated(request);
-        diff += std::chrono::system_clock::now() - start;
+        request.add_t(t + TIMES_DT * static_cast<double>(index));
     }
-    return diff.count() * 1000 / loop_size;
 }
 
-double test_output_repeated_unary_elevation(size_t vector_size, size_t loop_size, ElevationServiceClient& elevation_service, bool does_return_xy)
+// POINT_SETS_PER_RUN requests of number_of_points points, each filled by add_points(request, x, y)
+template <typename Request, typename AddPoints>
+std::vector<Request> make_requests(const size_t number_of_points, const AddPoints& add_points)
 {
-    // Data
-    const std::vector<double> x(vector_size, 1.3);
-    const std::vector<double> y(vector_size, 2.7);
-    const double t(0.1);
-    auto start = std::chrono::system_clock::now();
-    std::chrono::duration<double> diff = start-start;
+    std::vector<Request> requests(POINT_SETS_PER_RUN);
+    std::vector<double> x, y;
+    for (size_t index = 0; index < requests.size(); ++index)
+    {
+        random_points(number_of_points, static_cast<unsigned int>(index), x, y);
+        add_points(requests[index], x, y);
+    }
+    return requests;
+}
 
-    ElevationRequest request;
-    add_points_to_request(request, x, y);
-    request.set_t(t);
+// Unary RPC of the stub, each client using its own copy of the requests in turn
+template <typename Request, typename Response>
+LoadClientFactory unary_load(const std::vector<Request>& requests,
+                             Status (ElevationService::Stub::*rpc)(ClientContext*, const Request&, Response*))
+{
+    return [requests, rpc](ElevationService::Stub& stub) -> LoadClient
+    {
+        std::vector<Request> client_requests(requests);
+        Response response;
+        return [&stub, client_requests, rpc, response](const size_t index) mutable -> Status
+        {
+            Request& request = client_requests[index % client_requests.size()];
+            set_request_time(request, request_time(index));
+            ClientContext context;
+            return (stub.*rpc)(&context, request, &response);
+        };
+    };
+}
+
+// A whole GetElevations stream of STREAM_TIME_STEPS time steps per request
+LoadClientFactory stream_load(const std::vector<ElevationRequest>& requests);
+LoadClientFactory stream_load(const std::vector<ElevationRequest>& requests)
+{
+    return [requests](ElevationService::Stub& stub) -> LoadClient
+    {
+        std::vector<ElevationRequest> client_requests(requests);
+        ElevationResponse response;
+        return [&stub, client_requests, response](const size_t index) mutable -> Status
+        {
+            ElevationRequest& request = client_requests[index % client_requests.size()];
+            request.set_t_start(request_time(index));
+            request.set_t_end(request_time(index) + (STREAM_TIME_STEPS - 0.5) * STREAM_DT);
+            request.set_dt(STREAM_DT);
+            ClientContext context;
+            std::unique_ptr<grpc::ClientReader<ElevationResponse> > reader(stub.GetElevations(&context, request));
+            while (reader->Read(&response))
+            {
+            }
+            return reader->Finish();
+        };
+    };
+}
 
-    // Compute average time response for requesting elevation
-    for (size_t ind = 0; ind < loop_size; ++ind)
+// One ElevationSession stream per client, open for the whole run: a request is one exchange
+LoadClientFactory session_load(const std::vector<double>& x, const std::vector<double>& y);
+LoadClientFactory session_load(const std::vector<double>& x, const std::vector<double>& y)
+{
+    return [x, y](ElevationService::Stub& stub) -> LoadClient
     {
-        start = std::chrono::system_clock::now();
-        elevation_service.get_elevation_output_repeated(request, does_return_xy);
-        diff += std::chrono::system_clock::now() - start;
-    }
-    return diff.count() * 1000 / loop_size;
+        // Finished once the client is done
+        const std::shared_ptr<ElevationSessionClient> session(new ElevationSessionClient(stub, x, y),
+                                                              [](ElevationSessionClient* client) {client->finish(); delete client;});
+        std::vector<double> z;
+        return [session, z](const size_t index) mutable -> Status
+        {
+            if (session->get_elevations(request_time(index), z))
+            {
+                return Status::OK;
+            }
+            return Status(grpc::StatusCode::UNAVAILABLE, "ElevationSession stream broken");
+        };
+    };
 }
 
-double test_repeated_unary_elevation(size_t vector_size, size_t loop_size, ElevationServiceClient& elevation_service, bool does_return_xy)
+// A nearly square grid of about number_of_points nodes, moving with the request
+std::vector<ElevationRequestGrid> make_grid_requests(const size_t number_of_points);
+std::vector<ElevationRequestGrid> make_grid_requests(const size_t number_of_points)
 {
-    // Data
-    const std::vector<double> x(vector_size, 1.3);
-    const std::vector<double> y(vector_size, 2.7);
-    const double t(0.1);
-    auto start = std::chrono::system_clock::now();
-    std::chrono::duration<double> diff = start-start;
+    const size_t nx = std::max(size_t(1), static_cast<size_t>(std::lround(std::sqrt(static_cast<double>(number_of_points)))));
+    const size_t ny = (number_of_points + nx - 1) / nx;
+    std::vector<ElevationRequestGrid> requests(POINT_SETS_PER_RUN);
+    for (size_t index = 0; index < requests.size(); ++index)
+    {
+        requests[index].set_x0(-500. + 10. * static_cast<double>(index));
+        requests[index].set_y0(-500. - 10. * static_cast<double>(index));
+        requests[index].set_dx(1000. / static_cast<double>(nx));
+        requests[index].set_dy(1000. / static_cast<double>(ny));
+        requests[index].set_nx(static_cast<uint32_t>(nx));
+        requests[index].set_ny(static_cast<uint32_t>(ny));
+    }
+    return requests;
+}
 
-    ElevationRequestRepeated request;
-    add_points_to_request_repeated(request, x, y);
-    request.set_t(t);
+// A 64 x 64 FFT grid covering the 1 km square, interpolated at the points
+void add_points_to_request_snapshot(ElevationRequestSnapshot& request, const std::vector<double>& x, const std::vector<double>& y);
+void add_points_to_request_snapshot(ElevationRequestSnapshot& request, const std::vector<double>& x, const std::vector<double>& y)
+{
+    ElevationRequestGrid* grid = request.mutable_grid();
+    grid->set_x0(-512.);
+    grid->set_y0(-512.);
+    grid->set_dx(17.);
+    grid->set_dy(17.);
+    grid->set_nx(64);
+    grid->set_ny(64);
+    for (size_t index = 0; index < std::min(x.size(), y.size()); ++index)
+    {
+        request.add_x(x[index]);
+        request.add_y(y[index]);
+    }
+}
 
-    // Compute average time response for requesting elevation
-    for (size_t ind = 0; ind < loop_size; ++ind)
+void add_points_to_request_times(ElevationRequestTimes& request, const std::vector<double>& x, const std::vector<double>& y);
+void add_points_to_request_times(ElevationRequestTimes& request, const std::vector<double>& x, const std::vector<double>& y)
+{
+    for (size_t index = 0; index < std::min(x.size(), y.size()); ++index)
     {
-        start = std::chrono::system_clock::now();
-        elevation_service.get_elevation_repeated(request, does_return_xy);
-        diff += std::chrono::system_clock::now() - start;
+        request.add_x(x[index]);
+        request.add_y(y[index]);
     }
-    return diff.count() * 1000 / loop_size;
+    set_request_time(request, 0);
 }
 
+std::string format_fixed(const double value, const int precision);
+std::string format_fixed(const double value, const int precision)
+{
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(precision) << value;
+    return stream.str();
+}
 
-void write_mardown_results(size_t vector_size, size_t loop_size, ElevationServiceClient& elevation_service)
+void write_markdown_header(const std::string& first_column);
+void write_markdown_header(const std::string& first_column)
 {
-    std::cout << "## " << loop_size << " requests. Vector of size " << vector_size << "." << std::endl << std::endl
-              << "Input                    | Output          | Average time per request (ms)" << std::endl
-              << "-------------------------|--------------------------------------|---------" << std::endl;
+    std::cout << first_column << " | Throughput (requests/s) | Mean (ms) | p50 (ms) | p99 (ms) | p99.9 (ms) | Max (ms) | Errors" << std::endl
+              << std::string(first_column.size(), '-') << "-|-------------------------|-----------|----------|----------|------------|----------|-------" << std::endl;
+}
+
+void write_markdown_row(const std::string& first_column, const LoadResult& result);
+void write_markdown_row(const std::string& first_column, const LoadResult& result)
+{
+    std::cout << first_column << " | " << format_fixed(result.throughput(), 0)
+              << " | " << format_fixed(result.latencies.mean() * 1000, 3)
+              << " | " << format_fixed(result.latencies.percentile(50) * 1000, 3)
+              << " | " << format_fixed(result.latencies.percentile(99) * 1000, 3)
+              << " | " << format_fixed(result.latencies.percentile(99.9) * 1000, 3)
+              << " | " << format_fixed(result.latencies.max() * 1000, 3)
+              << " | " << result.errors << std::endl;
+}
 
-    std::cout << "(repeated x, repeated y) | repeated z                           | "
-              << test_repeated_unary_elevation(vector_size, loop_size, elevation_service, false) << std::endl;
-    std::cout << "(repeated x, repeated y) | (repeated x, repeated y, repeated z) | "
-              << test_repeated_unary_elevation(vector_size, loop_size, elevation_service, true) << std::endl;
-    std::cout << "(repeated x, repeated y) | repeated (x, y, z)                   | "
-              << test_input_repeated_unary_elevation(vector_size, loop_size, elevation_service) << std::endl;
-    std::cout << "repeated (x, y)          | repeated z                           | "
-              << test_output_repeated_unary_elevation(vector_size, loop_size, elevation_service, false) << std::endl;
-    std::cout << "repeated (x, y)          | (repeated x, repeated y, repeated z) | "
-              << test_output_repeated_unary_elevation(vector_size, loop_size, elevation_service, true) << std::endl;
-    std::cout << "repeated (x, y)          | repeated (x, y, z)                   | "
-              << test_unary_elevation(vector_size, loop_size, elevation_service) << std::endl;
+// Every RPC of the service but SetWaveSpectrum (which would change the results of the others) with number_of_points points per request
+void write_mardown_results(const size_t number_of_points, const size_t number_of_requests, const std::vector<std::shared_ptr<grpc::Channel> >& channels,
+                           const LoadOptions& options, std::vector<BenchmarkResult>& results);
+void write_mardown_results(const size_t number_of_points, const size_t number_of_requests, const std::vector<std::shared_ptr<grpc::Channel> >& channels,
+                           const LoadOptions& options, std::vector<BenchmarkResult>& results)
+{
+    const std::vector<ElevationRequest> requests = make_requests<ElevationRequest>(number_of_points, add_points_to_request);
+    const std::vector<ElevationRequestRepeated> repeated_requests = make_requests<ElevationRequestRepeated>(number_of_points, add_points_to_request_repeated);
+    const std::vector<ElevationRequestPacked> packed_requests = make_requests<ElevationRequestPacked>(number_of_points,
+        [](ElevationRequestPacked& request, const std::vector<double>& x, const std::vector<double>& y) {add_points_to_request_packed(request, x, y);});
+    std::vector<double> x, y;
+    random_points(number_of_points, 0, x, y);
+
+    const std::vector<std::pair<std::string, LoadClientFactory> > rpcs{
+        {"GetElevation               ", unary_load(requests, &ElevationService::Stub::GetElevation)},
+        {"GetElevationInputRepeated  ", unary_load(repeated_requests, &ElevationService::Stub::GetElevationInputRepeated)},
+        {"GetElevationOutputRepeated ", unary_load(requests, &ElevationService::Stub::GetElevationOutputRepeated)},
+        {"GetElevationOutputRepeatedZ", unary_load(requests, &ElevationService::Stub::GetElevationOutputRepeatedZ)},
+        {"GetElevationRepeated       ", unary_load(repeated_requests, &ElevationService::Stub::GetElevationRepeated)},
+        {"GetElevationRepeatedZ      ", unary_load(repeated_requests, &ElevationService::Stub::GetElevationRepeatedZ)},
+        {"GetElevationRepeatedFloat  ", unary_load(repeated_requests, &ElevationService::Stub::GetElevationRepeatedFloat)},
+        {"GetElevationPacked         ", unary_load(packed_requests, &ElevationService::Stub::GetElevationPacked)},
+        {"GetElevationPackedZ        ", unary_load(packed_requests, &ElevationService::Stub::GetElevationPackedZ)},
+        {"GetElevationGrid           ", unary_load(make_grid_requests(number_of_points), &ElevationService::Stub::GetElevationGrid)},
+        {"GetElevationSnapshot       ", unary_load(make_requests<ElevationRequestSnapshot>(number_of_points, add_points_to_request_snapshot),
+                                                   &ElevationService::Stub::GetElevationSnapshot)},
+        {"GetElevationTimes          ", unary_load(make_requests<ElevationRequestTimes>(number_of_points, add_points_to_request_times),
+                                                   &ElevationService::Stub::GetElevationTimes)},
+        {"GetElevations              ", stream_load(requests)},
+        {"ElevationSession           ", session_load(x, y)}};
+
+    std::cout << "## " << number_of_requests << " requests. " << number_of_points << " point(s) per request." << std::endl << std::endl
+              << "GetElevationTimes: " << TIMES_PER_REQUEST << " times per request. GetElevations: a whole stream of "
+              << STREAM_TIME_STEPS << " time steps per request. ElevationSession: one exchange per request." << std::endl << std::endl;
+    write_markdown_header("RPC                        ");
+    for (const auto& rpc : rpcs)
+    {
+        const LoadResult result = run_load(channels, options, number_of_requests, rpc.second);
+        write_markdown_row(rpc.first, result);
+        results.push_back(BenchmarkResult{rpc.first.substr(0, rpc.first.find(' ')), number_of_points, result});
+    }
     std::cout << std::endl;
 }
 
-std::string add_spaces(size_t size)
+void write_mardown_repeated_results(const std::vector<size_t>& vector_sizes, const size_t number_of_requests, const std::vector<std::shared_ptr<grpc::Channel> >& channels,
+                                    const LoadOptions& options, std::vector<BenchmarkResult>& results);
+void write_mardown_repeated_results(const std::vector<size_t>& vector_sizes, const size_t number_of_requests, const std::vector<std::shared_ptr<grpc::Channel> >& channels,
+                                    const LoadOptions& options, std::vector<BenchmarkResult>& results)
 {
-    return (size < 10 ? "     " :
-           (size < 100 ? "    " :
-           (size < 1000 ? "   " :
-           (size < 10000 ? "  " :
-           (size < 100000 ? " " :
-            "" )))));
+    std::cout << "## " << number_of_requests << " requests. (repeated x, repeated y) + (repeated x, repeated y, repeated z)" << std::endl << std::endl;
+    write_markdown_header("Vector size");
+    for (const size_t vector_size : vector_sizes)
+    {
+        const LoadResult result = run_load(channels, options, number_of_requests,
+            unary_load(make_requests<ElevationRequestRepeated>(vector_size, add_points_to_request_repeated), &ElevationService::Stub::GetElevationRepeated));
+        std::ostringstream size;
+        size << vector_size << add_spaces(vector_size);
+        write_markdown_row(size.str(), result);
+        results.push_back(BenchmarkResult{"GetElevationRepeated", vector_size, result});
+    }
+    std::cout << std::endl;
+}
+
+// Same results as the markdown, for scripts: latencies in milliseconds
+void write_json_results(std::ostream& stream, const LoadOptions& options, const size_t number_of_channels, const std::vector<BenchmarkResult>& results);
+void write_json_results(std::ostream& stream, const LoadOptions& options, const size_t number_of_channels, const std::vector<BenchmarkResult>& results)
+{
+    stream << "{" << std::endl
+           << "  \"mode\": \"" << to_string(options.mode) << "\"," << std::endl
+           << "  \"clients\": " << options.clients << "," << std::endl
+           << "  \"channels\": " << number_of_channels << "," << std::endl
+           << "  \"rate\": " << options.rate << "," << std::endl
+           << "  \"results\": [";
+    for (size_t index = 0; index < results.size(); ++index)
+    {
+        const BenchmarkResult& result = results[index];
+        const LatencyHistogram& latencies = result.load.latencies;
+        stream << (index > 0 ? "," : "") << std::endl
+               << "    {\"rpc\": \"" << result.rpc << "\", \"points\": " << result.points
+               << ", \"requests\": " << result.load.requests << ", \"errors\": " << result.load.errors
+               << ", \"duration_s\": " << result.load.duration << ", \"throughput_rps\": " << result.load.throughput()
+               << ", \"latency_ms\": {\"mean\": " << latencies.mean() * 1000
+               << ", \"p50\": " << latencies.percentile(50) * 1000 << ", \"p90\": " << latencies.percentile(90) * 1000
+               << ", \"p99\": " << latencies.percentile(99) * 1000 << ", \"p999\": " << latencies.percentile(99.9) * 1000
+               << ", \"max\": " << latencies.max() * 1000 << "}}";
+    }
+    stream << std::endl << "  ]" << std::endl << "}" << std::endl;
 }
 
-void write_mardown_repeated_results(std::vector<size_t> vector_sizes, size_t loop_size, ElevationServiceClient& elevation_service)
+// Difference between GetElevationRepeatedFloat and GetElevationRepeatedZ on points spread over a square
+void write_mardown_float_accuracy(ElevationServiceClient& elevation_service)
 {
-    std::cout << "## " << loop_size << " requests. (repeated x, repeated y) + (repeated x, repeated y, repeated z)" << std::endl << std::endl
-              << "Vector size  | Average time per request (ms)" << std::endl
-              << "-------------|------------------------------" << std::endl;
+    std::cout << "## Accuracy of the single precision elevations (GetElevationRepeatedFloat)" << std::endl << std::endl
+              << "Points within (m) | t (s)  | Max. error (m) | RMS error (m)" << std::endl
+              << "------------------|--------|----------------|--------------" << std::endl;
 
-    for (size_t vector_size : vector_sizes)
+    const size_t points_per_side = 100;
+    for (const double half_width : {10., 100., 1000.})
     {
-        std::cout << vector_size << add_spaces(vector_size) << "       | "
-                << test_repeated_unary_elevation(vector_size, loop_size, elevation_service, true) << std::endl;
+        for (const double t : {0.1, 10000.1})
+        {
+            std::vector<double> x, y;
+            for (size_t i = 0; i < points_per_side; ++i)
+            {
+                for (size_t j = 0; j < points_per_side; ++j)
+                {
+                    x.push_back(half_width * (2. * i / (points_per_side - 1) - 1.));
+                    y.push_back(half_width * (2. * j / (points_per_side - 1) - 1.));
+                }
+            }
+            ElevationRequestRepeated request;
+            add_points_to_request_repeated(request, x, y);
+            request.set_t(t);
+            const ElevationResponseRepeated reference = elevation_service.get_elevation_repeated(request, false);
+            const ElevationResponseRepeatedFloat single = elevation_service.get_elevation_repeated_float(request);
+            double max_error = 0;
+            double square_error = 0;
+            const int size = std::min(reference.z_size(), single.z_size());
+            for (int i = 0; i < size; ++i)
+            {
+                const double error = std::abs(single.z(i) - reference.z(i));
+                max_error = std::max(max_error, error);
+                square_error += error * error;
+            }
+            std::cout << half_width << add_spaces(static_cast<size_t>(half_width)) << "            | "
+                      << t << " | " << max_error << " | " << std::sqrt(square_error / std::max(size, 1)) << std::endl;
+        }
     }
     std::cout << std::endl;
 }
 
+// Where the time of each RPC went on the server: the client latency minus the compute time is
+// spent in gRPC (queueing, (de)serialization and transport)
+void write_mardown_server_stats(ElevationServiceClient& elevation_service);
+void write_mardown_server_stats(ElevationServiceClient& elevation_service)
+{
+    const wave::ServerStatsResponse stats = elevation_service.get_server_stats();
+    std::cout << "## Server statistics" << std::endl << std::endl
+              << "RPC                        | Calls | Errors | Compute p50 (ms) | Compute p99 (ms) | Reply p99 (ms) | Points p50 | Request p50 (B) | Response p50 (B)" << std::endl
+              << "---------------------------|-------|--------|------------------|------------------|----------------|------------|-----------------|-----------------" << std::endl;
+    for (const wave::RpcStats& rpc : stats.rpcs())
+    {
+        std::cout << rpc.method() << std::string(rpc.method().size() < 26 ? 26 - rpc.method().size() : 0, ' ')
+                  << " | " << rpc.calls() << " | " << rpc.errors()
+                  << " | " << format_fixed(rpc.compute_time().p50() * 1000, 3)
+                  << " | " << format_fixed(rpc.compute_time().p99() * 1000, 3)
+                  << " | " << format_fixed(rpc.reply_time().p99() * 1000, 3)
+                  << " | " << rpc.points().p50()
+                  << " | " << rpc.request_bytes().p50()
+                  << " | " << rpc.response_bytes().p50() << std::endl;
+    }
+    std::cout << std::endl << "Cache: " << stats.cache_hits() << " hit(s), " << stats.cache_misses() << " miss(es). Batching: "
+              << stats.batched_requests() << " request(s) in " << stats.batches() << " batch(es)." << std::endl << std::endl;
+}
+
 int main(int argc, char const * const argv[])
 {
     // Inputs
@@ -155,6 +422,11 @@ int main(int argc, char const * const argv[])
     args::HelpFlag help(parser, "help", "Display this help menu", {'h', "help"});
     args::ValueFlag<int> input_port(parser, "port", "The port to use", {'p', "port"});
     args::ValueFlag<std::string> input_ip(parser, "ip", "The ip to use", {"ip"});
+    args::ValueFlag<int> input_clients(parser, "clients", "Number of concurrent clients (threads), each with its own streams (1 by default).", {"clients"});
+    args::ValueFlag<int> input_channels(parser, "channels", "Number of connections shared by the clients (one per client by default).", {"channels"});
+    args::ValueFlag<double> input_rate(parser, "rate", "Open loop: requests per second, all clients together. By default, each client sends its next request as soon as it gets a response (closed loop).", {"rate"});
+    args::ValueFlag<int> input_requests(parser, "requests", "Number of requests of each benchmark (10000 for 1 point per request, 1000 otherwise, by default).", {"requests"});
+    args::ValueFlag<std::string> input_json(parser, "json", "Also writes the results to this file, in JSON.", {"json"});
     try
     {
         parser.ParseCLI(argc, argv);
@@ -194,28 +466,76 @@ int main(int argc, char const * const argv[])
       ip = args::get(input_ip);
     }
 
-    ElevationServiceClient elevation_service(grpc::CreateChannel(
-        ip + ":" + port, grpc::InsecureChannelCredentials()));
-    std::cout << std::endl;
+    LoadOptions options;
+    if (input_clients)
+    {
+        if (args::get(input_clients) <= 0)
+        {
+            std::cerr << "The number of clients should be strictly positive." << std::endl;
+            return 1;
+        }
+        options.clients = static_cast<size_t>(args::get(input_clients));
+    }
+    size_t number_of_channels = options.clients;
+    if (input_channels)
+    {
+        if (args::get(input_channels) <= 0)
+        {
+            std::cerr << "The number of channels should be strictly positive." << std::endl;
+            return 1;
+        }
+        number_of_channels = static_cast<size_t>(args::get(input_channels));
+    }
+    if (input_rate)
+    {
+        if (not(args::get(input_rate) > 0))
+        {
+            std::cerr << "The request rate should be strictly positive." << std::endl;
+            return 1;
+        }
+        options.mode = LoadMode::OPEN_LOOP;
+        options.rate = args::get(input_rate);
+    }
+    if (input_requests && args::get(input_requests) <= 0)
+    {
+        std::cerr << "The number of requests should be strictly positive." << std::endl;
+        return 1;
+    }
 
-    size_t vector_size = 1;
-    size_t loop_size = 10000;
-    write_mardown_results(vector_size, loop_size, elevation_service);
-
-    vector_size = 1000;
-    loop_size = 1000;
-    write_mardown_results(vector_size, loop_size, elevation_service);
-
-    std::vector<size_t> vector_sizes{1, 100, 1000, 2000, 5000, 10000, 50000, 100000};
-    loop_size = 1000;
-    write_mardown_repeated_results(vector_sizes, loop_size, elevation_service);
-/*
-    // Server streaming elevation
-    const double dt(0.1);
-    const double t_start(0.0);
-    const double t_end(0.25);
-    std::cout << "Server Streaming Elevation" << std::endl << std::endl;
-    elevation_service.get_elevations(x, y, dt, t_start, t_end);
-*/
+    const std::vector<std::shared_ptr<grpc::Channel> > channels = open_channels(ip + ":" + port, number_of_channels);
+    ElevationServiceClient elevation_service(channels.front());
+    std::cout << std::endl << to_string(options.mode) << ", " << options.clients << " client(s) on " << channels.size() << " connection(s)";
+    if (options.mode == LoadMode::OPEN_LOOP)
+    {
+        std::cout << ", " << options.rate << " requests/s";
+    }
+    std::cout << ". The latencies are measured with a steady clock";
+    if (options.mode == LoadMode::OPEN_LOOP)
+    {
+        std::cout << ", from the time each request was due";
+    }
+    std::cout << "." << std::endl << std::endl;
+
+    std::vector<BenchmarkResult> results;
+    const size_t requests = input_requests ? static_cast<size_t>(args::get(input_requests)) : 0;
+    write_mardown_results(1, requests > 0 ? requests : 10000, channels, options, results);
+    write_mardown_results(1000, requests > 0 ? requests : 1000, channels, options, results);
+
+    const std::vector<size_t> vector_sizes{1, 100, 1000, 2000, 5000, 10000, 50000, 100000};
+    write_mardown_repeated_results(vector_sizes, requests > 0 ? requests : 1000, channels, options, results);
+
+    write_mardown_float_accuracy(elevation_service);
+    write_mardown_server_stats(elevation_service);
+
+    if (input_json)
+    {
+        std::ofstream json(args::get(input_json));
+        if (not(json))
+        {
+            std::cerr << "Could not write " << args::get(input_json) << std::endl;
+            return 1;
+        }
+        write_json_results(json, options, channels.size(), results);
+    }
     return 0;
 }
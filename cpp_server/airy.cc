@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <yaml-cpp/yaml.h>
+#include "airy.hh"
+#include "parallel_elevation.hh"
+#include "wave_fields_kernel.hh"
+#include "yaml_value.hh"
+
+#define PI (4.0 * std::atan(1.0))
+#define G 9.81
+
+double jonswap(const double omega, const double hs, const double tp, const double gamma)
+{
+    const double omega0 = 2 * PI / tp;
+    const double sigma = (omega <= omega0) ? 0.07 : 0.09;
+    const double ratio = omega0 / omega;
+    const double alpha = ratio * ratio * ratio * ratio;
+    const double awm_5 = (1 - 0.287 * std::log(gamma)) * 5.0 / 16.0 * alpha / omega * hs * hs;
+    const double bwm_4 = 1.25 * alpha;
+    const double kappa = (omega - omega0) / (sigma * omega0);
+    return awm_5 * std::exp(-bwm_4) * std::pow(gamma, std::exp(-0.5 * kappa * kappa));
+}
+
+AiryParameters::AiryParameters():
+    waves_propagating_to(0), hs(0), tp(0), gamma(0), omega(), seed(0),
+    spreading(NONE), spreading_exponent(0), number_of_directions(1), pruning(0)
+{
+}
+
+AiryParameters parse_airy_parameters(const std::string& yaml)
+{
+    YAML::Node node;
+    try
+    {
+        node = YAML::Load(yaml);
+    }
+    catch (const YAML::Exception& e)
+    {
+        throw std::invalid_argument(std::string("Invalid YAML: ") + e.what());
+    }
+    if (not(node.IsMap()))
+    {
+        throw std::invalid_argument("The parameters should be a YAML map.");
+    }
+    AiryParameters parameters;
+    parameters.waves_propagating_to = get_yaml_value<double>(node, "waves propagating to");
+    parameters.hs = get_yaml_value<double>(node, "Hs");
+    parameters.tp = get_yaml_value<double>(node, "Tp");
+    parameters.gamma = get_yaml_value<double>(node, "gamma");
+    parameters.omega = get_yaml_value<std::vector<double> >(node, "omega");
+    if (node["seed"])
+    {
+        parameters.seed = get_yaml_value<unsigned int>(node, "seed");
+    }
+    if (node["spreading"])
+    {
+        const YAML::Node spreading = node["spreading"];
+        const std::string type = get_yaml_value<std::string>(spreading, "type");
+        if (type == "cos2s")
+        {
+            parameters.spreading = AiryParameters::COS2S;
+            parameters.spreading_exponent = get_yaml_value<double>(spreading, "s");
+        }
+        else if (type == "cosn")
+        {
+            parameters.spreading = AiryParameters::COSN;
+            parameters.spreading_exponent = get_yaml_value<double>(spreading, "n");
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown spreading type '" + type + "': should be cos2s or cosn.");
+        }
+        const int number_of_directions = get_yaml_value<int>(spreading, "directions");
+        if (number_of_directions < 1 || parameters.spreading_exponent <= 0)
+        {
+            throw std::invalid_argument("The spreading should have at least one direction, and a strictly positive exponent.");
+        }
+        parameters.number_of_directions = static_cast<size_t>(number_of_directions);
+    }
+    if (node["pruning"])
+    {
+        parameters.pruning = get_yaml_value<double>(node, "pruning");
+        if (not(parameters.pruning >= 0 && parameters.pruning < 1))
+        {
+            throw std::invalid_argument("pruning should be a fraction of the variance, in [0, 1[.");
+        }
+    }
+    if (parameters.hs < 0 || parameters.tp <= 0 || parameters.gamma <= 0)
+    {
+        throw std::invalid_argument("Hs should be positive, Tp and gamma strictly positive.");
+    }
+    if (parameters.omega.size() < 2)
+    {
+        throw std::invalid_argument("omega should contain at least two angular frequencies.");
+    }
+    // Before any allocation: the lines are built for every (omega, psi) couple before pruning
+    if (parameters.number_of_directions > AIRY_MAX_LINES / parameters.omega.size())
+    {
+        std::stringstream ss;
+        ss << "There should be at most " << AIRY_MAX_LINES << " spectrum lines (got " << parameters.omega.size() << " angular frequencies and "
+           << parameters.number_of_directions << " directions).";
+        throw std::invalid_argument(ss.str());
+    }
+    for (size_t index = 0; index < parameters.omega.size(); ++index)
+    {
+        if (parameters.omega[index] <= 0 || (index > 0 && parameters.omega[index] <= parameters.omega[index - 1]))
+        {
+            std::stringstream ss;
+            ss << "omega should be strictly positive and in increasing order (got " << parameters.omega[index] << " at index " << index << ").";
+            throw std::invalid_argument(ss.str());
+        }
+    }
+    return parameters;
+}
+
+std::vector<double> spectral_densities(const AiryParameters& parameters);
+std::vector<double> spectral_densities(const AiryParameters& parameters)
+{
+    std::vector<double> si;
+    si.reserve(parameters.omega.size());
+    for (const double omega : parameters.omega)
+    {
+        si.push_back(jonswap(omega, parameters.hs, parameters.tp, parameters.gamma));
+    }
+    return si;
+}
+
+std::vector<double> wave_numbers(const std::vector<double>& omega);
+std::vector<double> wave_numbers(const std::vector<double>& omega)
+{
+    std::vector<double> k;
+    k.reserve(omega.size());
+    for (const double w : omega)
+    {
+        k.push_back(w * w / G);
+    }
+    return k;
+}
+
+std::vector<double> random_phases(const size_t n, const unsigned int seed);
+std::vector<double> random_phases(const size_t n, const unsigned int seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> distribution(0, 2 * PI);
+    std::vector<double> phase;
+    phase.reserve(n);
+    for (size_t index = 0; index < n; ++index)
+    {
+        phase.push_back(distribution(generator));
+    }
+    return phase;
+}
+
+std::vector<double> directions(const AiryParameters& parameters);
+std::vector<double> directions(const AiryParameters& parameters)
+{
+    const double psi0 = parameters.waves_propagating_to * PI / 180;
+    std::vector<double> psi;
+    for (size_t j = 0; j < parameters.number_of_directions; ++j)
+    {
+        psi.push_back(std::fmod(psi0 + 2 * PI * static_cast<double>(j) / static_cast<double>(parameters.number_of_directions), 2 * PI));
+    }
+    return psi;
+}
+
+std::vector<double> spreading(const AiryParameters& parameters, const std::vector<double>& psi);
+std::vector<double> spreading(const AiryParameters& parameters, const std::vector<double>& psi)
+{
+    const double psi0 = parameters.waves_propagating_to * PI / 180;
+    std::vector<double> dj;
+    for (const double direction : psi)
+    {
+        switch (parameters.spreading)
+        {
+            case AiryParameters::COS2S:
+                dj.push_back(cos2s_spreading(direction, psi0, parameters.spreading_exponent));
+                break;
+            case AiryParameters::COSN:
+                dj.push_back(cosn_spreading(direction, psi0, parameters.spreading_exponent));
+                break;
+            default:
+                dj.push_back(1);
+        }
+    }
+    return dj;
+}
+
+// Directional lines, pruned as requested
+WaveSpectrum lines_of(const AiryParameters& parameters, const std::vector<double>& omega, const std::vector<double>& si, const std::vector<double>& k,
+                      const std::vector<double>& psi, const std::vector<double>& dj, const std::vector<double>& phase, PruningReport& report);
+WaveSpectrum lines_of(const AiryParameters& parameters, const std::vector<double>& omega, const std::vector<double>& si, const std::vector<double>& k,
+                      const std::vector<double>& psi, const std::vector<double>& dj, const std::vector<double>& phase, PruningReport& report)
+{
+    const double dpsi = (parameters.spreading == AiryParameters::NONE) ? 1 : 2 * PI / static_cast<double>(psi.size());
+    SpectrumLines lines = discretize_directional_spectrum(omega, si, k, psi, dj, dpsi, phase);
+    report = prune_spectrum_lines(lines, parameters.pruning);
+    return lines.to_wave_spectrum();
+}
+
+Airy::Airy(const AiryParameters& parameters):
+    psi_(directions(parameters)),
+    dj_(spreading(parameters, psi_)),
+    omega_(parameters.omega),
+    si_(spectral_densities(parameters)),
+    k_(wave_numbers(parameters.omega)),
+    phase_(random_phases(parameters.omega.size() * psi_.size(), parameters.seed)),
+    pruning_report_(),
+    wave_spectrum_(lines_of(parameters, omega_, si_, k_, psi_, dj_, phase_, pruning_report_))
+{
+}
+
+void Airy::elevations(const double* x, const double* y, const size_t n, const double t, double* eta, WorkerPool& pool) const
+{
+    compute_elevations(x, y, n, t, wave_spectrum_, eta, pool);
+}
+
+// Same splitting as the parallel elevations: small requests stay on the calling thread
+void for_each_chunk(const size_t n, const WaveSpectrum& wave_spectrum, WorkerPool& pool, const std::function<void(size_t, size_t)>& f);
+void for_each_chunk(const size_t n, const WaveSpectrum& wave_spectrum, WorkerPool& pool, const std::function<void(size_t, size_t)>& f)
+{
+    const size_t lines = std::max(wave_spectrum.size(), size_t(1));
+    if (pool.size() == 1 || n * lines < PARALLEL_ELEVATION_THRESHOLD)
+    {
+        f(0, n);
+        return;
+    }
+    pool.parallel_for(n, std::max(PARALLEL_ELEVATION_CHUNK / lines, size_t(1)), f);
+}
+
+void Airy::wave_fields(const double* x, const double* y, const double* z, const size_t n, const double t,
+                       double* eta, double* pdyn, double* vx, double* vy, double* vz, WorkerPool& pool) const
+{
+    for_each_chunk(n, wave_spectrum_, pool, [&](const size_t begin, const size_t end)
+    {
+        compute_wave_fields(x + begin, y + begin, z + begin, end - begin, t, wave_spectrum_,
+                            eta + begin, pdyn + begin, vx + begin, vy + begin, vz + begin);
+    });
+}
+
+void Airy::dynamic_pressures(const double* x, const double* y, const double* z, const size_t n, const double t,
+                             double* pdyn, WorkerPool& pool) const
+{
+    std::vector<double> eta(n), vx(n), vy(n), vz(n);
+    wave_fields(x, y, z, n, t, eta.data(), pdyn, vx.data(), vy.data(), vz.data(), pool);
+}
+
+void Airy::orbital_velocities(const double* x, const double* y, const double* z, const size_t n, const double t,
+                              double* vx, double* vy, double* vz, WorkerPool& pool) const
+{
+    std::vector<double> eta(n), pdyn(n);
+    wave_fields(x, y, z, n, t, eta.data(), pdyn.data(), vx, vy, vz, pool);
+}
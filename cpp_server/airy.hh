@@ -0,0 +1,94 @@
+#ifndef AIRY_HH
+#define AIRY_HH
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "directional_spectrum.hh"
+#include "wave_spectrum.hh"
+#include "worker_pool.hh"
+
+// Joint North Sea Project spectrum (in s m^2/rad), with sigma = 0.07 below the
+// peak angular frequency 2 pi / tp and 0.09 above.
+double jonswap(const double omega, const double hs, const double tp, const double gamma);
+
+// Upper bound on the number of (omega, psi) couples of a model: each of them is a spectrum line
+#define AIRY_MAX_LINES (size_t(1) << 20)
+
+// Parameters of the Airy model, as given to the set_parameters RPC in YAML:
+//     waves propagating to: 90    # in degrees, 0 for waves propagating to the North, 90 to the East
+//     Hs: 5                       # significant wave height (in m)
+//     Tp: 15                      # peak period (in s)
+//     gamma: 1.2                  # JONSWAP shape parameter
+//     omega: [0.1, 0.2, 0.3]      # angular frequencies (in rad/s), in increasing order
+//     seed: 0                     # optional: seed of the random phases
+//     spreading:                  # optional: short-crested sea instead of a single direction
+//         type: cos2s             # cos2s (with s) or cosn (with n), see directional_spectrum.hh
+//         s: 10
+//         directions: 36          # evenly spaced over 360 degrees, starting at 'waves propagating to'
+//     pruning: 1e-4               # optional: drops the weakest lines, up to this fraction of the variance
+struct AiryParameters
+{
+    AiryParameters();
+    enum Spreading {NONE, COS2S, COSN};
+    double waves_propagating_to;
+    double hs;
+    double tp;
+    double gamma;
+    std::vector<double> omega;
+    unsigned int seed;
+    Spreading spreading;
+    double spreading_exponent;      //!< s for COS2S, n for COSN
+    size_t number_of_directions;    //!< 1 if spreading is NONE
+    double pruning;                 //!< Fraction of the variance the pruned lines can hold (0: no pruning)
+};
+
+// Throws std::invalid_argument if a key is missing, a value is inconsistent or there would be
+// more than AIRY_MAX_LINES spectrum lines.
+AiryParameters parse_airy_parameters(const std::string& yaml);
+
+// Linear irregular waves in infinite depth, using a JONSWAP spectrum and a
+// single propagation direction (no stretching). As implemented in xdyn and in
+// python_server/airy.py: the elevations are computed by the same kernels as
+// wave_server's, the amplitude of each line being sqrt(2 S(omega) domega).
+// With a directional spreading, there is one line per (omega, psi) couple, of
+// amplitude sqrt(2 S(omega) D(psi) domega dpsi), before pruning.
+class Airy
+{
+    public:
+        explicit Airy(const AiryParameters& parameters);
+
+        const WaveSpectrum& wave_spectrum() const {return wave_spectrum_;}
+        const std::vector<double>& omega() const {return omega_;} //!< Angular frequencies (in rad/s)
+        const std::vector<double>& si() const {return si_;}       //!< Spectral density for each omega (in s m^2/rad)
+        const std::vector<double>& k() const {return k_;}         //!< Wave number for each omega (in rad/m)
+        const std::vector<double>& psi() const {return psi_;}     //!< Propagation directions (in rad)
+        const std::vector<double>& dj() const {return dj_;}       //!< Spreading for each psi (in 1/rad), {1} for a single direction
+        //! Random phase for each (omega[i], psi[j]) couple, at i * psi().size() + j (in rad)
+        const std::vector<double>& phase() const {return phase_;}
+        const PruningReport& pruning_report() const {return pruning_report_;}
+
+        void elevations(const double* x, const double* y, const size_t n, const double t, double* eta, WorkerPool& pool) const;
+        // Elevation (in m), dynamic pressure (in Pa) and orbital velocity (in m/s) in a single
+        // pass over the spectrum (see wave_fields_kernel.hh). All but eta are zero above the free surface.
+        void wave_fields(const double* x, const double* y, const double* z, const size_t n, const double t,
+                         double* eta, double* pdyn, double* vx, double* vy, double* vz, WorkerPool& pool) const;
+        // In Pascal. Zero above the free surface.
+        void dynamic_pressures(const double* x, const double* y, const double* z, const size_t n, const double t,
+                               double* pdyn, WorkerPool& pool) const;
+        // In meters per second. Zero above the free surface.
+        void orbital_velocities(const double* x, const double* y, const double* z, const size_t n, const double t,
+                                double* vx, double* vy, double* vz, WorkerPool& pool) const;
+
+    private:
+        std::vector<double> psi_;
+        std::vector<double> dj_;
+        std::vector<double> omega_;
+        std::vector<double> si_;
+        std::vector<double> k_;
+        std::vector<double> phase_;
+        PruningReport pruning_report_;
+        WaveSpectrum wave_spectrum_;
+};
+
+#endif
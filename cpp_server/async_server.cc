@@ -0,0 +1,378 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+#include <google/protobuf/arena.h>
+#include "async_server.hh"
+#include "wave.grpc.pb.h"
+
+using google::protobuf::Arena;
+using grpc::CompletionQueue;
+using grpc::Server;
+using grpc::ServerAsyncReaderWriter;
+using grpc::ServerAsyncResponseWriter;
+using grpc::ServerAsyncWriter;
+using grpc::ServerBuilder;
+using grpc::ServerCompletionQueue;
+using grpc::ServerContext;
+using grpc::Status;
+using wave::ElevationRequest;
+using wave::ElevationResponse;
+using wave::ElevationRequestRepeated;
+using wave::ElevationResponseRepeated;
+using wave::ElevationResponseRepeatedFloat;
+using wave::ElevationRequestPacked;
+using wave::ElevationResponsePacked;
+using wave::ElevationSessionRequest;
+using wave::ElevationRequestGrid;
+using wave::ElevationRequestSnapshot;
+using wave::ElevationResponseSnapshot;
+using wave::ElevationRequestTimes;
+using wave::ElevationResponseTimes;
+using wave::ElevationRequestShared;
+using wave::ElevationResponseShared;
+using wave::SetWaveSpectrumRequest;
+using wave::SetWaveSpectrumResponse;
+using wave::ServerStatsRequest;
+using wave::ServerStatsResponse;
+using wave::ElevationService;
+
+// Status of a call whose handler threw e: the other exceptions (an allocation failure
+// for instance) end this call only, not the server and the calls it is serving
+Status exception_status(const std::exception& e);
+Status exception_status(const std::exception& e)
+{
+    if (dynamic_cast<const std::invalid_argument*>(&e))
+    {
+        return Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+    }
+    if (dynamic_cast<const std::bad_alloc*>(&e))
+    {
+        return Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "not enough memory to serve the request");
+    }
+    return Status(grpc::StatusCode::INTERNAL, e.what());
+}
+
+// State of one RPC, used as the completion queue tag
+class AsyncCall
+{
+    public:
+        virtual ~AsyncCall() {}
+        virtual void proceed(const bool ok) = 0;
+};
+
+template <typename Request, typename Response>
+class AsyncUnaryCall final : public AsyncCall
+{
+    public:
+        typedef void (ElevationService::AsyncService::*RequestMethod)(ServerContext*, Request*, ServerAsyncResponseWriter<Response>*,
+                                                                      CompletionQueue*, ServerCompletionQueue*, void*);
+        typedef void (ElevationHandlers::*Handler)(const Request&, Response*);
+
+        AsyncUnaryCall(ElevationService::AsyncService& service, ServerCompletionQueue& queue, ElevationHandlers& handlers,
+                       const Rpc rpc, const RequestMethod request_method, const Handler handler):
+            service_(service), queue_(queue), handlers_(handlers), rpc_(rpc), request_method_(request_method), handler_(handler),
+            context_(), arena_(), request_(Arena::CreateMessage<Request>(&arena_)), reply_(Arena::CreateMessage<Response>(&arena_)),
+            responder_(&context_), finishing_(false), finish_start_()
+        {
+            (service_.*request_method_)(&context_, request_, &responder_, &queue_, &queue_, this);
+        }
+
+        void proceed(const bool ok) override
+        {
+            if (finishing_ || not(ok))
+            {
+                if (finishing_ && ok && finish_start_ != std::chrono::steady_clock::time_point())
+                {
+                    const std::chrono::nanoseconds reply_time = std::chrono::steady_clock::now() - finish_start_;
+                    handlers_.metrics().rpc(rpc_).reply_time.record(static_cast<uint64_t>(reply_time.count()));
+                }
+                delete this;
+                return;
+            }
+            // Be ready for the next call before serving this one
+            new AsyncUnaryCall(service_, queue_, handlers_, rpc_, request_method_, handler_);
+            finishing_ = true;
+            try
+            {
+                (handlers_.*handler_)(*request_, reply_);
+            }
+            catch (const std::exception& e)
+            {
+                responder_.FinishWithError(exception_status(e), this);
+                return;
+            }
+            // Serializes reply_ and hands it to the transport: done once this call is back in the queue
+            finish_start_ = std::chrono::steady_clock::now();
+            responder_.Finish(*reply_, Status::OK, this);
+        }
+
+    private:
+        ElevationService::AsyncService& service_;
+        ServerCompletionQueue& queue_;
+        ElevationHandlers& handlers_;
+        const Rpc rpc_;
+        const RequestMethod request_method_;
+        const Handler handler_;
+        ServerContext context_;
+        Arena arena_;       //!< Owns request_ and reply_, and everything they allocate
+        Request* request_;
+        Response* reply_;
+        ServerAsyncResponseWriter<Response> responder_;
+        bool finishing_;
+        std::chrono::steady_clock::time_point finish_start_;   //!< Only set when the reply is sent
+};
+
+template <typename Request, typename Response>
+void listen_unary(ElevationService::AsyncService& service, ServerCompletionQueue& queue, ElevationHandlers& handlers, const Rpc rpc,
+                  const typename AsyncUnaryCall<Request, Response>::RequestMethod request_method,
+                  const typename AsyncUnaryCall<Request, Response>::Handler handler)
+{
+    new AsyncUnaryCall<Request, Response>(service, queue, handlers, rpc, request_method, handler);
+}
+
+// GetElevations: each message is computed while the previous one is being written. A write
+// fails (ok is false) once the client is gone, which ends the call and the computations.
+class AsyncElevationsCall final : public AsyncCall
+{
+    public:
+        AsyncElevationsCall(ElevationService::AsyncService& service, ServerCompletionQueue& queue, ElevationHandlers& handlers):
+            service_(service), queue_(queue), handlers_(handlers),
+            context_(), arena_(), request_(Arena::CreateMessage<ElevationRequest>(&arena_)),
+            writing_(Arena::CreateMessage<ElevationResponse>(&arena_)), next_(Arena::CreateMessage<ElevationResponse>(&arena_)),
+            writer_(&context_), stream_(), has_next_(false), finishing_(false), status_(Status::OK)
+        {
+            service_.RequestGetElevations(&context_, request_, &writer_, &queue_, &queue_, this);
+        }
+
+        void proceed(const bool ok) override
+        {
+            if (finishing_ || not(ok))
+            {
+                delete this;
+                return;
+            }
+            if (not(stream_))
+            {
+                new AsyncElevationsCall(service_, queue_, handlers_);
+                try
+                {
+                    stream_.reset(new ElevationStream(handlers_, *request_));
+                }
+                catch (const std::exception& e)
+                {
+                    finishing_ = true;
+                    writer_.Finish(exception_status(e), this);
+                    return;
+                }
+                has_next_ = compute_next();
+            }
+            if (has_next_)
+            {
+                std::swap(writing_, next_);
+                writer_.Write(*writing_, this);
+                has_next_ = compute_next();
+            }
+            else
+            {
+                finishing_ = true;
+                writer_.Finish(status_, this);
+            }
+        }
+
+    private:
+        // A write may be in progress: an error ends the stream once it is done
+        bool compute_next()
+        {
+            try
+            {
+                return stream_->next(next_);
+            }
+            catch (const std::exception& e)
+            {
+                status_ = exception_status(e);
+                return false;
+            }
+        }
+
+        ElevationService::AsyncService& service_;
+        ServerCompletionQueue& queue_;
+        ElevationHandlers& handlers_;
+        ServerContext context_;
+        Arena arena_;       //!< Owns request_ and the two messages, which are reused for the whole stream
+        ElevationRequest* request_;
+        ElevationResponse* writing_;    //!< Being written: must not change until the write is done
+        ElevationResponse* next_;
+        ServerAsyncWriter<ElevationResponse> writer_;
+        std::unique_ptr<ElevationStream> stream_;
+        bool has_next_;
+        bool finishing_;
+        Status status_;     //!< Sent once there is no next message
+};
+
+// ElevationSession: reads one message, writes its elevations, and reads the next one
+class AsyncSessionCall final : public AsyncCall
+{
+    public:
+        AsyncSessionCall(ElevationService::AsyncService& service, ServerCompletionQueue& queue, ElevationHandlers& handlers):
+            service_(service), queue_(queue), handlers_(handlers),
+            context_(), arena_(), request_(Arena::CreateMessage<ElevationSessionRequest>(&arena_)), reply_(Arena::CreateMessage<ElevationResponseRepeated>(&arena_)),
+            stream_(&context_), session_(handlers), state_(REQUESTED)
+        {
+            service_.RequestElevationSession(&context_, &stream_, &queue_, &queue_, this);
+        }
+
+        void proceed(const bool ok) override
+        {
+            switch (state_)
+            {
+                case REQUESTED:
+                    if (not(ok))
+                    {
+                        delete this;
+                        return;
+                    }
+                    new AsyncSessionCall(service_, queue_, handlers_);
+                    read();
+                    break;
+                case READING:
+                    if (not(ok))
+                    {
+                        // The client is done writing
+                        finish(Status::OK);
+                        return;
+                    }
+                    try
+                    {
+                        session_.next(*request_, reply_);
+                    }
+                    catch (const std::exception& e)
+                    {
+                        finish(exception_status(e));
+                        return;
+                    }
+                    state_ = WRITING;
+                    stream_.Write(*reply_, this);
+                    break;
+                case WRITING:
+                    if (not(ok))
+                    {
+                        delete this;
+                        return;
+                    }
+                    read();
+                    break;
+                case FINISHING:
+                    delete this;
+                    break;
+            }
+        }
+
+    private:
+        void read()
+        {
+            state_ = READING;
+            request_->Clear();
+            stream_.Read(request_, this);
+        }
+
+        void finish(const Status& status)
+        {
+            state_ = FINISHING;
+            stream_.Finish(status, this);
+        }
+
+        enum State {REQUESTED, READING, WRITING, FINISHING};
+        ElevationService::AsyncService& service_;
+        ServerCompletionQueue& queue_;
+        ElevationHandlers& handlers_;
+        ServerContext context_;
+        Arena arena_;       //!< Owns request_ and reply_, which are reused for every message of the session
+        ElevationSessionRequest* request_;
+        ElevationResponseRepeated* reply_;
+        ServerAsyncReaderWriter<ElevationResponseRepeated, ElevationSessionRequest> stream_;
+        PointSetSession session_;
+        State state_;
+};
+
+void listen(ElevationService::AsyncService& service, ServerCompletionQueue& queue, ElevationHandlers& handlers);
+void listen(ElevationService::AsyncService& service, ServerCompletionQueue& queue, ElevationHandlers& handlers)
+{
+    typedef ElevationService::AsyncService Service;
+    listen_unary<ElevationRequest, ElevationResponse>(service, queue, handlers, Rpc::GET_ELEVATION,
+        &Service::RequestGetElevation, &ElevationHandlers::get_elevation);
+    listen_unary<ElevationRequestRepeated, ElevationResponse>(service, queue, handlers, Rpc::GET_ELEVATION_INPUT_REPEATED,
+        &Service::RequestGetElevationInputRepeated, &ElevationHandlers::get_elevation_input_repeated);
+    listen_unary<ElevationRequest, ElevationResponseRepeated>(service, queue, handlers, Rpc::GET_ELEVATION_OUTPUT_REPEATED,
+        &Service::RequestGetElevationOutputRepeated, &ElevationHandlers::get_elevation_output_repeated);
+    listen_unary<ElevationRequestRepeated, ElevationResponseRepeated>(service, queue, handlers, Rpc::GET_ELEVATION_REPEATED,
+        &Service::RequestGetElevationRepeated, &ElevationHandlers::get_elevation_repeated);
+    listen_unary<ElevationRequest, ElevationResponseRepeated>(service, queue, handlers, Rpc::GET_ELEVATION_OUTPUT_REPEATED_Z,
+        &Service::RequestGetElevationOutputRepeatedZ, &ElevationHandlers::get_elevation_output_repeated_z);
+    listen_unary<ElevationRequestRepeated, ElevationResponseRepeated>(service, queue, handlers, Rpc::GET_ELEVATION_REPEATED_Z,
+        &Service::RequestGetElevationRepeatedZ, &ElevationHandlers::get_elevation_repeated_z);
+    listen_unary<ElevationRequestRepeated, ElevationResponseRepeatedFloat>(service, queue, handlers, Rpc::GET_ELEVATION_REPEATED_FLOAT,
+        &Service::RequestGetElevationRepeatedFloat, &ElevationHandlers::get_elevation_repeated_float);
+    listen_unary<ElevationRequestPacked, ElevationResponsePacked>(service, queue, handlers, Rpc::GET_ELEVATION_PACKED,
+        &Service::RequestGetElevationPacked, &ElevationHandlers::get_elevation_packed);
+    listen_unary<ElevationRequestPacked, ElevationResponsePacked>(service, queue, handlers, Rpc::GET_ELEVATION_PACKED_Z,
+        &Service::RequestGetElevationPackedZ, &ElevationHandlers::get_elevation_packed_z);
+    listen_unary<ElevationRequestGrid, ElevationResponseRepeated>(service, queue, handlers, Rpc::GET_ELEVATION_GRID,
+        &Service::RequestGetElevationGrid, &ElevationHandlers::get_elevation_grid);
+    listen_unary<ElevationRequestSnapshot, ElevationResponseSnapshot>(service, queue, handlers, Rpc::GET_ELEVATION_SNAPSHOT,
+        &Service::RequestGetElevationSnapshot, &ElevationHandlers::get_elevation_snapshot);
+    listen_unary<ElevationRequestTimes, ElevationResponseTimes>(service, queue, handlers, Rpc::GET_ELEVATION_TIMES,
+        &Service::RequestGetElevationTimes, &ElevationHandlers::get_elevation_times);
+    listen_unary<ElevationRequestShared, ElevationResponseShared>(service, queue, handlers, Rpc::GET_ELEVATION_SHARED,
+        &Service::RequestGetElevationShared, &ElevationHandlers::get_elevation_shared);
+    listen_unary<SetWaveSpectrumRequest, SetWaveSpectrumResponse>(service, queue, handlers, Rpc::SET_WAVE_SPECTRUM,
+        &Service::RequestSetWaveSpectrum, &ElevationHandlers::set_wave_spectrum);
+    listen_unary<ServerStatsRequest, ServerStatsResponse>(service, queue, handlers, Rpc::GET_SERVER_STATS,
+        &Service::RequestGetServerStats, &ElevationHandlers::get_server_stats);
+    new AsyncElevationsCall(service, queue, handlers);
+    new AsyncSessionCall(service, queue, handlers);
+}
+
+void poll(ServerCompletionQueue& queue);
+void poll(ServerCompletionQueue& queue)
+{
+    void* tag = nullptr;
+    bool ok = false;
+    while (queue.Next(&tag, &ok))
+    {
+        static_cast<AsyncCall*>(tag)->proceed(ok);
+    }
+}
+
+void run_async_server(const std::string& server_address, ElevationHandlers& handlers, const size_t number_of_polling_threads)
+{
+    ElevationService::AsyncService service;
+    ServerBuilder builder;
+    builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
+    builder.RegisterService(&service);
+    std::vector<std::unique_ptr<ServerCompletionQueue> > queues;
+    for (size_t index = 0; index < std::max(number_of_polling_threads, size_t(1)); ++index)
+    {
+        queues.push_back(builder.AddCompletionQueue());
+    }
+    std::unique_ptr<Server> server(builder.BuildAndStart());
+    std::cout << "Asynchronous server listening on " << server_address << " with " << queues.size() << " completion queue(s)" << std::endl;
+
+    std::vector<std::thread> threads;
+    for (const std::unique_ptr<ServerCompletionQueue>& queue : queues)
+    {
+        listen(service, *queue, handlers);
+        threads.push_back(std::thread(poll, std::ref(*queue)));
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
@@ -0,0 +1,14 @@
+#ifndef ASYNC_SERVER_HH
+#define ASYNC_SERVER_HH
+
+#include <cstddef>
+#include <string>
+#include "elevation_handlers.hh"
+
+// Serves ElevationService with gRPC's asynchronous API: each of the
+// number_of_polling_threads threads polls its own completion queue and runs
+// the handlers to completion without ever blocking on the network.
+// Does not return.
+void run_async_server(const std::string& server_address, ElevationHandlers& handlers, const size_t number_of_polling_threads);
+
+#endif
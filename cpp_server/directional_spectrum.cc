@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include "directional_spectrum.hh"
+
+#define PI (4.0 * std::atan(1.0))
+
+double cos2s_spreading(const double psi, const double psi0, const double s)
+{
+    // G(s) = 2^(2s - 1) Gamma(s + 1)^2 / (pi Gamma(2s + 1)), through its logarithm not to overflow for large s
+    const double log_g = (2 * s - 1) * std::log(2.0) + 2 * std::lgamma(s + 1) - std::log(PI) - std::lgamma(2 * s + 1);
+    // cos^2((psi - psi0) / 2), without the sign of the cosine
+    const double cos2 = (1 + std::cos(psi - psi0)) / 2;
+    return std::exp(log_g) * std::pow(cos2, s);
+}
+
+double cosn_spreading(const double psi, const double psi0, const double n)
+{
+    const double c = std::cos(psi - psi0);
+    if (c <= 0)
+    {
+        return 0;
+    }
+    // C(n) = Gamma(n / 2 + 1) / (sqrt(pi) Gamma(n / 2 + 1 / 2))
+    const double log_c = std::lgamma(n / 2 + 1) - 0.5 * std::log(PI) - std::lgamma(n / 2 + 0.5);
+    return std::exp(log_c) * std::pow(c, n);
+}
+
+SpectrumLines::SpectrumLines():
+    a(), omega(), psi(), k(), phase()
+{
+}
+
+SpectrumLines::SpectrumLines(const WaveSpectrum& wave_spectrum):
+    a(wave_spectrum.a(), wave_spectrum.a() + wave_spectrum.size()),
+    omega(wave_spectrum.omega(), wave_spectrum.omega() + wave_spectrum.size()),
+    psi(wave_spectrum.psi(), wave_spectrum.psi() + wave_spectrum.size()),
+    k(wave_spectrum.k(), wave_spectrum.k() + wave_spectrum.size()),
+    phase(wave_spectrum.phase(), wave_spectrum.phase() + wave_spectrum.size())
+{
+}
+
+WaveSpectrum SpectrumLines::to_wave_spectrum() const
+{
+    return WaveSpectrum(a, omega, psi, k, phase);
+}
+
+SpectrumLines discretize_directional_spectrum(const std::vector<double>& omega, const std::vector<double>& si, const std::vector<double>& k,
+                                              const std::vector<double>& psi, const std::vector<double>& dj, const double dpsi,
+                                              const std::vector<double>& phase)
+{
+    const size_t n = omega.size();
+    const size_t m = psi.size();
+    if (si.size() != n || k.size() != n || dj.size() != m || phase.size() != n * m || n < 2)
+    {
+        throw std::invalid_argument("discretize_directional_spectrum: inconsistent sizes");
+    }
+    SpectrumLines lines;
+    lines.a.reserve(n * m);
+    lines.omega.reserve(n * m);
+    lines.psi.reserve(n * m);
+    lines.k.reserve(n * m);
+    lines.phase.reserve(n * m);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const double previous = (i > 0) ? omega[i - 1] : 2 * omega[0] - omega[1];
+        const double next = (i + 1 < n) ? omega[i + 1] : 2 * omega[n - 1] - omega[n - 2];
+        const double domega = (next - previous) / 2;
+        for (size_t j = 0; j < m; ++j)
+        {
+            lines.a.push_back(std::sqrt(2 * si[i] * domega * dj[j] * dpsi));
+            lines.omega.push_back(omega[i]);
+            lines.psi.push_back(psi[j]);
+            lines.k.push_back(k[i]);
+            lines.phase.push_back(phase[i * m + j]);
+        }
+    }
+    return lines;
+}
+
+PruningReport::PruningReport():
+    kept_lines(0), dropped_lines(0), total_variance(0), dropped_variance(0), max_elevation_error(0)
+{
+}
+
+PruningReport prune_spectrum_lines(SpectrumLines& lines, const double variance_fraction)
+{
+    if (not(variance_fraction >= 0 && variance_fraction < 1))
+    {
+        throw std::invalid_argument("The pruning threshold should be a fraction of the variance, in [0, 1[.");
+    }
+    PruningReport report;
+    std::vector<size_t> weakest_first(lines.size());
+    std::iota(weakest_first.begin(), weakest_first.end(), size_t(0));
+    std::sort(weakest_first.begin(), weakest_first.end(), [&lines](const size_t i, const size_t j) {return std::abs(lines.a[i]) < std::abs(lines.a[j]);});
+    for (const double a : lines.a)
+    {
+        report.total_variance += a * a / 2;
+    }
+    std::vector<bool> dropped(lines.size(), false);
+    for (const size_t index : weakest_first)
+    {
+        if (variance_fraction == 0)
+        {
+            break;
+        }
+        const double variance = lines.a[index] * lines.a[index] / 2;
+        if (report.dropped_variance + variance > variance_fraction * report.total_variance || report.dropped_lines + 1 == lines.size())
+        {
+            break;
+        }
+        report.dropped_variance += variance;
+        report.max_elevation_error += std::abs(lines.a[index]);
+        dropped[index] = true;
+        ++report.dropped_lines;
+    }
+    size_t kept = 0;
+    for (size_t index = 0; index < lines.size(); ++index)
+    {
+        if (not(dropped[index]))
+        {
+            lines.a[kept] = lines.a[index];
+            lines.omega[kept] = lines.omega[index];
+            lines.psi[kept] = lines.psi[index];
+            lines.k[kept] = lines.k[index];
+            lines.phase[kept] = lines.phase[index];
+            ++kept;
+        }
+    }
+    lines.a.resize(kept);
+    lines.omega.resize(kept);
+    lines.psi.resize(kept);
+    lines.k.resize(kept);
+    lines.phase.resize(kept);
+    report.kept_lines = kept;
+    return report;
+}
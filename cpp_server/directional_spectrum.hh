@@ -0,0 +1,59 @@
+#ifndef DIRECTIONAL_SPECTRUM_HH
+#define DIRECTIONAL_SPECTRUM_HH
+
+#include <cstddef>
+#include <vector>
+#include "wave_spectrum.hh"
+
+// Directional spreading functions D(psi) (in 1/rad), normalised so that their
+// integral over [0, 2pi[ is 1. psi0 is the mean propagation direction (in rad).
+//
+// cos-2s (Longuet-Higgins): D = G(s) cos^2s((psi - psi0) / 2), spread over all directions
+double cos2s_spreading(const double psi, const double psi0, const double s);
+// cos-n: D = C(n) cos^n(psi - psi0) within pi/2 of psi0, and 0 beyond
+double cosn_spreading(const double psi, const double psi0, const double n);
+
+// Spectrum lines before they are laid out in a WaveSpectrum
+struct SpectrumLines
+{
+    explicit SpectrumLines(const WaveSpectrum& wave_spectrum);
+    SpectrumLines();
+    size_t size() const {return a.size();}
+    WaveSpectrum to_wave_spectrum() const;
+
+    std::vector<double> a;      //!< Amplitude (in m)
+    std::vector<double> omega;  //!< Angular frequency (in rad/s)
+    std::vector<double> psi;    //!< Direction (in rad)
+    std::vector<double> k;      //!< Wave number (in rad/m)
+    std::vector<double> phase;  //!< Random phase (in rad)
+};
+
+// Short-crested sea: one line per (omega[i], psi[j]) couple (i major), of amplitude
+// sqrt(2 S(omega[i]) D(psi[j]) domega dpsi), si being S and dj being D. Each omega
+// stands for the interval between the midpoints with its neighbours, each psi for
+// dpsi. phase[i * psi.size() + j] is the phase of the (i, j) line. A single
+// direction (long-crested sea) is given by dj = {1} and dpsi = 1.
+SpectrumLines discretize_directional_spectrum(const std::vector<double>& omega, const std::vector<double>& si, const std::vector<double>& k,
+                                              const std::vector<double>& psi, const std::vector<double>& dj, const double dpsi,
+                                              const std::vector<double>& phase);
+
+// What pruning removed from a spectrum. The elevations of the pruned spectrum
+// differ from the full one by at most max_elevation_error at any point and time,
+// and by sqrt(dropped_variance) in the mean square sense.
+struct PruningReport
+{
+    PruningReport();
+    size_t kept_lines;
+    size_t dropped_lines;
+    double total_variance;      //!< Of the full spectrum, sum of a^2 / 2 (in m^2)
+    double dropped_variance;    //!< Sum of a^2 / 2 over the dropped lines (in m^2)
+    double max_elevation_error; //!< Sum of the absolute values of the dropped amplitudes (in m)
+};
+
+// Drops the weakest lines (smallest |a|), as long as the variance they hold together stays below
+// variance_fraction times the total variance (0 keeps every line, even those of zero
+// amplitude). The order of the kept lines is unchanged.
+// Throws std::invalid_argument unless 0 <= variance_fraction < 1.
+PruningReport prune_spectrum_lines(SpectrumLines& lines, const double variance_fraction);
+
+#endif
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cstring>
+#include "elevation_batcher.hh"
+#include "parallel_elevation.hh"
+
+ElevationBatcher::ElevationBatcher(const std::chrono::microseconds window, WorkerPool& pool):
+    window_(window), pool_(pool), mutex_(), open_batches_(), batches_(0), batched_requests_(0)
+{
+}
+
+void ElevationBatcher::compute(const uint64_t spectrum_version, const std::shared_ptr<const WaveSpectrum>& wave_spectrum, const double t,
+                               const double* x, const double* y, const size_t n, double* z)
+{
+    if (window_.count() <= 0 || n > ELEVATION_BATCHER_MAX_REQUEST_POINTS)
+    {
+        compute_elevations(x, y, n, t, *wave_spectrum, z, pool_);
+        return;
+    }
+    uint64_t t_bits = 0;
+    std::memcpy(&t_bits, &t, sizeof(t_bits));
+    const Key key(spectrum_version, t_bits);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    const auto open_batch = open_batches_.find(key);
+    if (open_batch != open_batches_.end() && open_batch->second->x.size() + n <= ELEVATION_BATCHER_MAX_BATCH_POINTS)
+    {
+        // Join the batch and wait for the request that opened it to compute it
+        const std::shared_ptr<Batch> batch = open_batch->second;
+        const size_t offset = batch->x.size();
+        try
+        {
+            batch->x.insert(batch->x.end(), x, x + n);
+            batch->y.insert(batch->y.end(), y, y + n);
+        }
+        catch (...)
+        {
+            // x and y must keep the same size for the other requests
+            batch->x.resize(offset);
+            batch->y.resize(offset);
+            throw;
+        }
+        ++batch->requests;
+        if (batch->x.size() >= ELEVATION_BATCHER_MAX_BATCH_POINTS)
+        {
+            batch->changed.notify_all();
+        }
+        batch->changed.wait(lock, [&batch] {return batch->done;});
+        lock.unlock();
+        if (batch->error)
+        {
+            std::rethrow_exception(batch->error);
+        }
+        std::copy(batch->z.begin() + static_cast<std::ptrdiff_t>(offset), batch->z.begin() + static_cast<std::ptrdiff_t>(offset + n), z);
+        return;
+    }
+
+    // Open a new batch (replacing a full one, which is being computed), wait for the other requests, then compute it
+    const std::shared_ptr<Batch> batch = std::make_shared<Batch>(wave_spectrum);
+    batch->x.assign(x, x + n);
+    batch->y.assign(y, y + n);
+    batch->requests = 1;
+    open_batches_[key] = batch;
+    batch->changed.wait_until(lock, std::chrono::steady_clock::now() + window_,
+                              [&batch] {return batch->x.size() >= ELEVATION_BATCHER_MAX_BATCH_POINTS;});
+    const auto still_open = open_batches_.find(key);
+    if (still_open != open_batches_.end() && still_open->second == batch)
+    {
+        open_batches_.erase(still_open);
+    }
+    lock.unlock();
+
+    // Closed: nobody else modifies the batch until done is set, which the other requests wait for even if computing it fails
+    try
+    {
+        batch->z.resize(batch->x.size());
+        compute_elevations(batch->x.data(), batch->y.data(), batch->x.size(), t, *batch->wave_spectrum, batch->z.data(), pool_);
+    }
+    catch (...)
+    {
+        batch->error = std::current_exception();
+    }
+    if (not(batch->error) && batch->requests > 1)
+    {
+        ++batches_;
+        batched_requests_ += batch->requests;
+    }
+    lock.lock();
+    batch->done = true;
+    lock.unlock();
+    batch->changed.notify_all();
+    if (batch->error)
+    {
+        std::rethrow_exception(batch->error);
+    }
+    std::copy(batch->z.begin(), batch->z.begin() + static_cast<std::ptrdiff_t>(n), z);
+}
@@ -0,0 +1,78 @@
+#ifndef ELEVATION_BATCHER_HH
+#define ELEVATION_BATCHER_HH
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "wave_spectrum.hh"
+#include "worker_pool.hh"
+
+// Only requests of up to this many points are batched: larger ones already fill the SIMD registers
+#define ELEVATION_BATCHER_MAX_REQUEST_POINTS 4096
+// A batch is computed as soon as it has this many points, even if its window is not over
+#define ELEVATION_BATCHER_MAX_BATCH_POINTS (size_t(1) << 16)
+
+// Coalesces the small requests of concurrent clients asking for the same t.
+//
+// The first request for a given (spectrum version, t) opens a batch and waits
+// for up to window: the requests for the same t arriving meanwhile append
+// their points to it and wait. The first request then computes all the points
+// in a single kernel pass (split across the pool if large enough) and each
+// request copies its own elevations back. Many small requests, whose kernel
+// calls would mostly be loop overheads and scalar tails, become a few large
+// ones, at the cost of up to window of latency for the first request of each
+// batch. All methods can be called concurrently, by as many threads as there
+// are requests being served. compute blocks its thread for up to window: it is
+// meant for the handler threads of the synchronous server, not for completion
+// queue threads.
+class ElevationBatcher
+{
+    public:
+        // A window of 0 disables batching: every request is computed on its own
+        ElevationBatcher(const std::chrono::microseconds window, WorkerPool& pool);
+
+        // Elevations of the n points (x, y) at t with wave_spectrum (whose version is
+        // spectrum_version), in z. Returns once they have been computed. If the batch could not be
+        // computed, every request of the batch throws the exception that prevented it.
+        void compute(const uint64_t spectrum_version, const std::shared_ptr<const WaveSpectrum>& wave_spectrum, const double t,
+                     const double* x, const double* y, const size_t n, double* z);
+
+        std::chrono::microseconds window() const {return window_;}
+        uint64_t batches() const {return batches_;}                 //!< Number of kernel passes made for several requests
+        uint64_t batched_requests() const {return batched_requests_;} //!< Number of requests computed in these passes
+
+    private:
+        struct Batch
+        {
+            explicit Batch(const std::shared_ptr<const WaveSpectrum>& wave_spectrum_):
+                wave_spectrum(wave_spectrum_), x(), y(), z(), requests(0), done(false), error(), changed()
+            {
+            }
+            std::shared_ptr<const WaveSpectrum> wave_spectrum;
+            std::vector<double> x;
+            std::vector<double> y;
+            std::vector<double> z;
+            size_t requests;
+            bool done;
+            std::exception_ptr error;           //!< Set with done if the batch could not be computed
+            std::condition_variable changed;    //!< Full (for the first request) or done (for the others)
+        };
+        typedef std::pair<uint64_t, uint64_t> Key;  //!< Spectrum version and bits of t
+
+        const std::chrono::microseconds window_;
+        WorkerPool& pool_;
+        std::mutex mutex_;
+        std::map<Key, std::shared_ptr<Batch> > open_batches_;  //!< Batches still accepting requests
+        std::atomic<uint64_t> batches_;
+        std::atomic<uint64_t> batched_requests_;
+};
+
+#endif
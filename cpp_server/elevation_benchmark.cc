@@ -0,0 +1,140 @@
+#include <cmath>
+#include <random>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "elevation_kernel.hh"
+#include "wave_spectrum.hh"
+
+// Floating point operations per term (one point and one spectrum line) of the vectorized
+// double precision kernels, an FMA counting as two (compares, blends and roundings are
+// not counted): 5 for the phase, 42 for the sine (reduction, both polynomials and
+// quadrant selection) and 2 to accumulate -a.sin. The same nominal count is used for
+// every kernel, so that their FLOP/s compare as their time per term does.
+#define FLOPS_PER_TERM 49
+// Largest number of terms of a benchmark (10^8 terms take about 1 s with the scalar kernel)
+#define MAX_TERMS 1e8
+#define BENCHMARK_T 100.1
+
+typedef void (*DoubleKernel)(const double* x, const double* y, const size_t n, const double t, const WaveSpectrum& wave_spectrum, double* z);
+typedef void (*FloatKernel)(const float* x, const float* y, const size_t n, const SinglePrecisionLines& lines, float* z);
+
+// Deep water spectrum of number_of_lines lines, with periods between 3 s and 30 s
+WaveSpectrum random_spectrum(const size_t number_of_lines);
+WaveSpectrum random_spectrum(const size_t number_of_lines)
+{
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::vector<double> a, omega, psi, k, phase;
+    for (size_t line = 0; line < number_of_lines; ++line)
+    {
+        const double w = 2 * M_PI / (3 + 27 * uniform(generator));
+        a.push_back(0.1 * uniform(generator));
+        omega.push_back(w);
+        psi.push_back(2 * M_PI * uniform(generator));
+        k.push_back(w * w / 9.81);
+        phase.push_back(2 * M_PI * uniform(generator));
+    }
+    return WaveSpectrum(a, omega, psi, k, phase);
+}
+
+// Spread over a 1 km square
+template <typename Real>
+void random_points(const size_t number_of_points, std::vector<Real>& x, std::vector<Real>& y)
+{
+    std::mt19937 generator(2);
+    std::uniform_real_distribution<double> coordinate(-500, 500);
+    x.resize(number_of_points);
+    y.resize(number_of_points);
+    for (size_t index = 0; index < number_of_points; ++index)
+    {
+        x[index] = static_cast<Real>(coordinate(generator));
+        y[index] = static_cast<Real>(coordinate(generator));
+    }
+}
+
+void set_counters(benchmark::State& state, const size_t number_of_terms);
+void set_counters(benchmark::State& state, const size_t number_of_terms)
+{
+    const double terms = static_cast<double>(number_of_terms);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * terms));
+    // Terms per second, inverted: time per term
+    state.counters["time/(point.line)"] = benchmark::Counter(terms, benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+    state.counters["FLOP"] = benchmark::Counter(terms * FLOPS_PER_TERM, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+// Kernels that neither this build nor the CPU support are skipped
+bool is_supported(benchmark::State& state, const ElevationKernelIsa isa);
+bool is_supported(benchmark::State& state, const ElevationKernelIsa isa)
+{
+    if (best_elevation_kernel_isa() < isa)
+    {
+        state.SkipWithError("Instruction set not supported");
+        return false;
+    }
+    return true;
+}
+
+void elevations(benchmark::State& state, const DoubleKernel kernel, const ElevationKernelIsa isa);
+void elevations(benchmark::State& state, const DoubleKernel kernel, const ElevationKernelIsa isa)
+{
+    const size_t number_of_lines = static_cast<size_t>(state.range(0));
+    const size_t number_of_points = static_cast<size_t>(state.range(1));
+    const WaveSpectrum wave_spectrum = random_spectrum(number_of_lines);
+    std::vector<double> x, y;
+    random_points(number_of_points, x, y);
+    std::vector<double> z(number_of_points);
+    const bool supported = is_supported(state, isa);
+    while (supported && state.KeepRunning())
+    {
+        kernel(x.data(), y.data(), number_of_points, BENCHMARK_T, wave_spectrum, z.data());
+        benchmark::DoNotOptimize(z.data());
+        benchmark::ClobberMemory();
+    }
+    set_counters(state, number_of_lines * number_of_points);
+}
+
+// The single precision lines are computed once, outside of the measurement, as GetElevationRepeatedFloat does once per request
+void float_elevations(benchmark::State& state, const FloatKernel kernel, const ElevationKernelIsa isa);
+void float_elevations(benchmark::State& state, const FloatKernel kernel, const ElevationKernelIsa isa)
+{
+    const size_t number_of_lines = static_cast<size_t>(state.range(0));
+    const size_t number_of_points = static_cast<size_t>(state.range(1));
+    const SinglePrecisionLines lines(random_spectrum(number_of_lines), BENCHMARK_T);
+    std::vector<float> x, y;
+    random_points(number_of_points, x, y);
+    std::vector<float> z(number_of_points);
+    const bool supported = is_supported(state, isa);
+    while (supported && state.KeepRunning())
+    {
+        kernel(x.data(), y.data(), number_of_points, lines, z.data());
+        benchmark::DoNotOptimize(z.data());
+        benchmark::ClobberMemory();
+    }
+    set_counters(state, number_of_lines * number_of_points);
+}
+
+// Spectrum lines x points, up to MAX_TERMS terms
+void sweep(benchmark::internal::Benchmark* benchmark);
+void sweep(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->ArgNames({"lines", "points"});
+    for (const int lines : {1, 128, 1000, 10000})
+    {
+        for (const int points : {1, 16, 1000, 100000})
+        {
+            if (static_cast<double>(lines) * points <= MAX_TERMS)
+            {
+                benchmark->Args({lines, points});
+            }
+        }
+    }
+}
+
+BENCHMARK_CAPTURE(elevations, scalar, compute_elevations_scalar, ElevationKernelIsa::SCALAR)->Apply(sweep);
+BENCHMARK_CAPTURE(elevations, avx2, compute_elevations_avx2, ElevationKernelIsa::AVX2)->Apply(sweep);
+BENCHMARK_CAPTURE(elevations, avx512, compute_elevations_avx512, ElevationKernelIsa::AVX512)->Apply(sweep);
+BENCHMARK_CAPTURE(float_elevations, scalar, compute_elevations_float_scalar, ElevationKernelIsa::SCALAR)->Apply(sweep);
+BENCHMARK_CAPTURE(float_elevations, avx2, compute_elevations_float_avx2, ElevationKernelIsa::AVX2)->Apply(sweep);
+BENCHMARK_CAPTURE(float_elevations, avx512, compute_elevations_float_avx512, ElevationKernelIsa::AVX512)->Apply(sweep);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include "elevation_cache.hh"
+
+ElevationCache::ElevationCache(const size_t capacity_in_bytes):
+    capacity_in_bytes_(capacity_in_bytes), mutex_(), entries_(), index_(), size_in_bytes_(0), current_version_(0), hits_(0), misses_(0)
+{
+}
+
+uint64_t bits_of(const double value);
+uint64_t bits_of(const double value)
+{
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// One multiply-xorshift round per coordinate: much cheaper than the elevations themselves
+ElevationCache::Key ElevationCache::make_key(const uint64_t spectrum_version, const double t, const double* x, const double* y, const size_t n)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL ^ n;
+    for (size_t index = 0; index < n; ++index)
+    {
+        hash = (hash ^ bits_of(x[index])) * 0x100000001B3ULL;
+        hash ^= hash >> 29;
+        hash = (hash ^ bits_of(y[index])) * 0x100000001B3ULL;
+        hash ^= hash >> 29;
+    }
+    Key key;
+    key.spectrum_version = spectrum_version;
+    key.t_bits = bits_of(t);
+    key.points_hash = hash;
+    return key;
+}
+
+size_t ElevationCache::entry_size_in_bytes(const size_t n)
+{
+    return sizeof(Entry) + 3 * n * sizeof(double);
+}
+
+bool ElevationCache::find(const uint64_t spectrum_version, const double t, const double* x, const double* y, const size_t n, double* z)
+{
+    if (capacity_in_bytes_ == 0)
+    {
+        return false;
+    }
+    const Key key = make_key(spectrum_version, t, x, y, n);
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto range = index_.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        const Entry& entry = *it->second;
+        if (entry.x.size() == n && std::equal(x, x + n, entry.x.begin()) && std::equal(y, y + n, entry.y.begin()))
+        {
+            std::copy(entry.z.begin(), entry.z.end(), z);
+            entries_.splice(entries_.begin(), entries_, it->second);
+            ++hits_;
+            return true;
+        }
+    }
+    ++misses_;
+    return false;
+}
+
+void ElevationCache::insert(const uint64_t spectrum_version, const double t, const double* x, const double* y, const size_t n, const double* z)
+{
+    const size_t size = entry_size_in_bytes(n);
+    if (size > capacity_in_bytes_)
+    {
+        return;
+    }
+    Entry entry;
+    entry.key = make_key(spectrum_version, t, x, y, n);
+    entry.x.assign(x, x + n);
+    entry.y.assign(y, y + n);
+    entry.z.assign(z, z + n);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (spectrum_version < current_version_)
+    {
+        return;
+    }
+    // Another handler may have computed the same request concurrently
+    const auto range = index_.equal_range(entry.key);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second->x == entry.x && it->second->y == entry.y)
+        {
+            return;
+        }
+    }
+    while (not(entries_.empty()) && size_in_bytes_ + size > capacity_in_bytes_)
+    {
+        erase(std::prev(entries_.end()));
+    }
+    entries_.push_front(std::move(entry));
+    index_.insert(std::make_pair(entries_.front().key, entries_.begin()));
+    size_in_bytes_ += size;
+}
+
+void ElevationCache::erase(const Entries::iterator entry)
+{
+    const auto range = index_.equal_range(entry->key);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second == entry)
+        {
+            index_.erase(it);
+            break;
+        }
+    }
+    size_in_bytes_ -= entry_size_in_bytes(entry->x.size());
+    entries_.erase(entry);
+}
+
+void ElevationCache::clear(const uint64_t spectrum_version)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Two SetWaveSpectrum can call clear in the opposite order of their versions
+    current_version_ = std::max(current_version_, spectrum_version);
+    for (Entries::iterator entry = entries_.begin(); entry != entries_.end();)
+    {
+        const Entries::iterator next = std::next(entry);
+        if (entry->key.spectrum_version < current_version_)
+        {
+            erase(entry);
+        }
+        entry = next;
+    }
+}
+
+size_t ElevationCache::size_in_bytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_in_bytes_;
+}
@@ -0,0 +1,78 @@
+#ifndef ELEVATION_CACHE_HH
+#define ELEVATION_CACHE_HH
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Elevations of recent requests, keyed by the version of the wave spectrum they
+// were computed with, by t and by the point set (x, y).
+//
+// Least recently used entries are evicted once the copies of x, y and z held
+// by the cache exceed capacity_in_bytes; a single request larger than that is
+// never cached. Entries are looked up by (version, t, hash of x and y), then x and y are
+// compared element by element, so a hash collision can only cost a miss.
+// All methods can be called concurrently.
+class ElevationCache
+{
+    public:
+        // A capacity of 0 disables the cache: find always misses and insert does nothing
+        explicit ElevationCache(const size_t capacity_in_bytes);
+
+        // Copies the cached elevations of the n points (x, y) at t into z. Returns false if they are not in the cache.
+        bool find(const uint64_t spectrum_version, const double t, const double* x, const double* y, const size_t n, double* z);
+        // Does nothing if spectrum_version is older than the version given to clear
+        void insert(const uint64_t spectrum_version, const double t, const double* x, const double* y, const size_t n, const double* z);
+        // Frees the entries of the versions older than spectrum_version, the new current version, at once
+        // when the spectrum changes (they could not be found anyway, but would wait for their eviction).
+        // The requests still computing with an older version cannot insert their elevations afterwards.
+        void clear(const uint64_t spectrum_version);
+
+        size_t capacity_in_bytes() const {return capacity_in_bytes_;}
+        size_t size_in_bytes() const;
+        uint64_t hits() const {return hits_;}
+        uint64_t misses() const {return misses_;}
+
+    private:
+        struct Key
+        {
+            uint64_t spectrum_version;
+            uint64_t t_bits;
+            uint64_t points_hash;
+            bool operator==(const Key& other) const
+            {
+                return spectrum_version == other.spectrum_version && t_bits == other.t_bits && points_hash == other.points_hash;
+            }
+        };
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const {return static_cast<size_t>((key.t_bits + key.spectrum_version) * 0x9E3779B97F4A7C15ULL ^ key.points_hash);}
+        };
+        struct Entry
+        {
+            Key key;
+            std::vector<double> x;
+            std::vector<double> y;
+            std::vector<double> z;
+        };
+        typedef std::list<Entry> Entries;
+
+        static Key make_key(const uint64_t spectrum_version, const double t, const double* x, const double* y, const size_t n);
+        static size_t entry_size_in_bytes(const size_t n);
+        void erase(const Entries::iterator entry);   //!< With its index, under mutex_
+
+        const size_t capacity_in_bytes_;
+        mutable std::mutex mutex_;
+        Entries entries_;   //!< Most recently used first
+        std::unordered_multimap<Key, Entries::iterator, KeyHash> index_;
+        size_t size_in_bytes_;
+        uint64_t current_version_;  //!< Latest version given to clear
+        std::atomic<uint64_t> hits_;
+        std::atomic<uint64_t> misses_;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "elevation_grid.hh"
+#include "parallel_elevation.hh"
+
+void compute_grid_elevations(const double x0, const double dx, const size_t nx,
+                             const double y0, const double dy, const size_t ny,
+                             const double t, const WaveSpectrum& wave_spectrum, double* z, WorkerPool& pool)
+{
+    // Each tile of lines adds its part to the elevations
+    std::fill(z, z + nx * ny, 0.0);
+    if (nx == 0 || ny == 0)
+    {
+        return;
+    }
+    const size_t lines = wave_spectrum.size();
+    const double* a = wave_spectrum.a();
+    const double* k_cos_psi = wave_spectrum.k_cos_psi();
+    const double* k_sin_psi = wave_spectrum.k_sin_psi();
+    const double* omega = wave_spectrum.omega();
+    const double* phase = wave_spectrum.phase();
+
+    const size_t tile_columns = std::min(nx, ELEVATION_GRID_MAX_TABLE_VALUES / 2);
+    const size_t tile_rows = std::min(ny, ELEVATION_GRID_MAX_TABLE_VALUES / 2);
+    const size_t tile_lines = std::max(std::min(lines, ELEVATION_GRID_MAX_TABLE_VALUES / (tile_columns + tile_rows)), size_t(1));
+    // x tables are line-major (contiguous along a row of the tile) and include the factor -a,
+    // y tables are point-major (contiguous along the lines of one row)
+    std::vector<double> sin_x(tile_lines * tile_columns), cos_x(tile_lines * tile_columns);
+    std::vector<double> sin_y(tile_rows * tile_lines), cos_y(tile_rows * tile_lines);
+    for (size_t j_begin = 0; j_begin < ny; j_begin += tile_rows)
+    {
+        const size_t rows = std::min(ny - j_begin, tile_rows);
+        for (size_t i_begin = 0; i_begin < nx; i_begin += tile_columns)
+        {
+            const size_t columns = std::min(nx - i_begin, tile_columns);
+            for (size_t line_begin = 0; line_begin < lines; line_begin += tile_lines)
+            {
+                const size_t number_of_lines = std::min(lines - line_begin, tile_lines);
+                for (size_t l = 0; l < number_of_lines; ++l)
+                {
+                    const size_t line = line_begin + l;
+                    for (size_t i = 0; i < columns; ++i)
+                    {
+                        const double theta = (x0 + static_cast<double>(i_begin + i) * dx) * k_cos_psi[line] - omega[line] * t + phase[line];
+                        sin_x[l * columns + i] = -a[line] * sin(theta);
+                        cos_x[l * columns + i] = -a[line] * cos(theta);
+                    }
+                }
+                for (size_t j = 0; j < rows; ++j)
+                {
+                    for (size_t l = 0; l < number_of_lines; ++l)
+                    {
+                        const double theta = (y0 + static_cast<double>(j_begin + j) * dy) * k_sin_psi[line_begin + l];
+                        sin_y[j * number_of_lines + l] = sin(theta);
+                        cos_y[j * number_of_lines + l] = cos(theta);
+                    }
+                }
+
+                // Rows are processed ELEVATION_GRID_ROW_BLOCK at a time, so that each value read from the x tables is used for several rows
+                const auto tile_rows_of = [&](const size_t begin, const size_t end)
+                {
+                    for (size_t i0 = 0; i0 < columns; i0 += ELEVATION_GRID_COLUMN_BLOCK)
+                    {
+                        const size_t block_columns = std::min(columns - i0, size_t(ELEVATION_GRID_COLUMN_BLOCK));
+                        for (size_t j0 = begin; j0 < end; j0 += ELEVATION_GRID_ROW_BLOCK)
+                        {
+                            const size_t block_rows = std::min(end - j0, size_t(ELEVATION_GRID_ROW_BLOCK));
+                            double block[ELEVATION_GRID_ROW_BLOCK][ELEVATION_GRID_COLUMN_BLOCK] = {};
+                            for (size_t l = 0; l < number_of_lines; ++l)
+                            {
+                                const double* sx = &sin_x[l * columns + i0];
+                                const double* cx = &cos_x[l * columns + i0];
+                                double c[ELEVATION_GRID_ROW_BLOCK] = {};
+                                double s[ELEVATION_GRID_ROW_BLOCK] = {};
+                                for (size_t r = 0; r < block_rows; ++r)
+                                {
+                                    c[r] = cos_y[(j0 + r) * number_of_lines + l];
+                                    s[r] = sin_y[(j0 + r) * number_of_lines + l];
+                                }
+                                // Missing rows of the last block have c = s = 0 and are not added
+                                for (size_t r = 0; r < ELEVATION_GRID_ROW_BLOCK; ++r)
+                                {
+                                    for (size_t i = 0; i < block_columns; ++i)
+                                    {
+                                        block[r][i] += sx[i] * c[r] + cx[i] * s[r];
+                                    }
+                                }
+                            }
+                            for (size_t r = 0; r < block_rows; ++r)
+                            {
+                                double* row = z + (j_begin + j0 + r) * nx + i_begin + i0;
+                                for (size_t i = 0; i < block_columns; ++i)
+                                {
+                                    row[i] += block[r][i];
+                                }
+                            }
+                        }
+                    }
+                };
+                // Each row costs about as much as computing columns/8 elevations point by point
+                if (pool.size() == 1 || rows * columns * number_of_lines < 8 * PARALLEL_ELEVATION_THRESHOLD)
+                {
+                    tile_rows_of(0, rows);
+                }
+                else
+                {
+                    pool.parallel_for(rows, std::max(8 * PARALLEL_ELEVATION_CHUNK / (number_of_lines * columns), size_t(1)), tile_rows_of);
+                }
+            }
+        }
+    }
+}
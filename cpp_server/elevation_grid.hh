@@ -0,0 +1,33 @@
+#ifndef ELEVATION_GRID_HH
+#define ELEVATION_GRID_HH
+
+#include <cstddef>
+#include "wave_spectrum.hh"
+#include "worker_pool.hh"
+
+// Largest number of points of a grid request (nx.ny)
+#define ELEVATION_GRID_MAX_POINTS (size_t(1) << 26)
+// The grid is accumulated by blocks of rows and columns: the block stays in L1
+// while the matching part of the x tables is swept for each line
+#define ELEVATION_GRID_ROW_BLOCK 4
+#define ELEVATION_GRID_COLUMN_BLOCK 128
+// The grid is computed by tiles of rows, columns and spectrum lines, whose tables hold at
+// most this many (line, axis value) couples (16 MiB for the four tables), whatever the
+// size of the grid and of the spectrum
+#define ELEVATION_GRID_MAX_TABLE_VALUES (size_t(1) << 20)
+
+// Elevations on the regular grid x[i] = x0 + i.dx (i in [0, nx)), y[j] = y0 + j.dy
+// (j in [0, ny)), stored row by row: z[j.nx + i] = compute_elevation(x[i], y[j], t, wave_spectrum).
+//
+// The phase of each line separates into an x term and a y term:
+//     sin(k.cos(psi).x[i] - omega.t + phase + k.sin(psi).y[j])
+//         = sin(X[i]).cos(Y[j]) + cos(X[i]).sin(Y[j])
+// so sines and cosines are only evaluated on the (nx + ny) axis values of each
+// line, and the grid is an accumulation of outer products of these tables,
+// i.e. 4 flops per (point, line) couple instead of a sine. The axis values are only
+// evaluated again for the tiles of very long rows or columns.
+void compute_grid_elevations(const double x0, const double dx, const size_t nx,
+                             const double y0, const double dy, const size_t ny,
+                             const double t, const WaveSpectrum& wave_spectrum, double* z, WorkerPool& pool);
+
+#endif
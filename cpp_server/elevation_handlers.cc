@@ -0,0 +1,549 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include "directional_spectrum.hh"
+#include "elevation_grid.hh"
+#include "elevation_handlers.hh"
+#include "elevation_times.hh"
+#include "packed_values.hh"
+#include "parallel_elevation.hh"
+#include "shared_points.hh"
+#include "wave_field_snapshot.hh"
+#include "wave_spectrum_file.hh"
+#include "wave_spectrum_yaml.hh"
+
+using wave::Point;
+using wave::ElevationRequest;
+using wave::ElevationResponse;
+using wave::ElevationPoint;
+using wave::ElevationRequestRepeated;
+using wave::ElevationResponseRepeated;
+using wave::ElevationResponseRepeatedFloat;
+using wave::ElevationRequestPacked;
+using wave::ElevationResponsePacked;
+using wave::ElevationSessionRequest;
+using wave::ElevationRequestGrid;
+using wave::ElevationRequestSnapshot;
+using wave::ElevationResponseSnapshot;
+using wave::ElevationRequestTimes;
+using wave::ElevationResponseTimes;
+using wave::ElevationRequestShared;
+using wave::ElevationResponseShared;
+using wave::SetWaveSpectrumRequest;
+using wave::SetWaveSpectrumResponse;
+using wave::ServerStatsRequest;
+using wave::ServerStatsResponse;
+using wave::RpcStats;
+using wave::Distribution;
+using wave::FlatDiscreteDirectionalWaveSpectrum;
+using wave::WaveSpectrumLine;
+
+WaveSpectrum to_wave_spectrum(const FlatDiscreteDirectionalWaveSpectrum& wave_spectrum)
+{
+    std::vector<double> a, omega, psi, k, phase;
+    for (const WaveSpectrumLine& spectrum_line : wave_spectrum.spectrum_lines())
+    {
+        a.push_back(spectrum_line.a());
+        omega.push_back(spectrum_line.omega());
+        psi.push_back(spectrum_line.psi());
+        k.push_back(spectrum_line.k());
+        phase.push_back(spectrum_line.phase());
+    }
+    return WaveSpectrum(a, omega, psi, k, phase);
+}
+
+ElevationHandlers::ElevationHandlers(const WaveSpectrum& wave_spectrum, WorkerPool& pool, const size_t cache_capacity_in_bytes,
+                                     const std::chrono::microseconds batch_window, const std::string& spectrum_directory):
+    wave_spectrum_(std::make_shared<const WaveSpectrum>(wave_spectrum)), spectrum_directory_(spectrum_directory), pool_(pool),
+    cache_(cache_capacity_in_bytes), batcher_(batch_window, pool)
+{
+}
+
+// Any client can send the file name: it should not reach outside of the spectrum directory, and the
+// error should not tell a missing file from an unreadable or invalid one.
+WaveSpectrum map_spectrum_directory_file(const std::string& directory, const std::string& file);
+WaveSpectrum map_spectrum_directory_file(const std::string& directory, const std::string& file)
+{
+    if (directory.empty())
+    {
+        throw std::invalid_argument("the server has no spectrum directory (see wave_server --spectrum-directory)");
+    }
+    if (file.empty() || file[0] == '/')
+    {
+        throw std::invalid_argument("the spectrum file should be a path relative to the spectrum directory");
+    }
+    size_t begin = 0;
+    while (begin <= file.size())
+    {
+        const size_t end = std::min(file.find('/', begin), file.size());
+        if (file.compare(begin, end - begin, "..") == 0)
+        {
+            throw std::invalid_argument("the path of the spectrum file should not contain '..'");
+        }
+        begin = end + 1;
+    }
+    try
+    {
+        return map_wave_spectrum_file(directory + "/" + file);
+    }
+    catch (const std::invalid_argument&)
+    {
+        throw std::invalid_argument("unable to load the wave spectrum file " + file + " of the spectrum directory");
+    }
+}
+
+void ElevationHandlers::set_wave_spectrum(const SetWaveSpectrumRequest& request, SetWaveSpectrumResponse* reply)
+{
+    const ResponseRecorder recorder(metrics_, Rpc::SET_WAVE_SPECTRUM, request, 0, *reply);
+    std::shared_ptr<const WaveSpectrum> wave_spectrum;
+    switch (request.spectrum_case())
+    {
+        case SetWaveSpectrumRequest::kLines:
+            wave_spectrum = std::make_shared<const WaveSpectrum>(to_wave_spectrum(request.lines()));
+            break;
+        case SetWaveSpectrumRequest::kYaml:
+            wave_spectrum = std::make_shared<const WaveSpectrum>(parse_wave_spectrum(request.yaml()));
+            break;
+        case SetWaveSpectrumRequest::kFile:
+            wave_spectrum = std::make_shared<const WaveSpectrum>(map_spectrum_directory_file(spectrum_directory_, request.file()));
+            break;
+        default:
+            throw std::invalid_argument("the request should contain the spectrum lines, their YAML or a spectrum file");
+    }
+    if (wave_spectrum->size() == 0)
+    {
+        throw std::invalid_argument("the wave spectrum should have at least one line");
+    }
+    if (request.pruning() != 0)
+    {
+        SpectrumLines lines(*wave_spectrum);
+        const PruningReport report = prune_spectrum_lines(lines, request.pruning());
+        wave_spectrum = std::make_shared<const WaveSpectrum>(lines.to_wave_spectrum());
+        reply->set_number_of_pruned_lines(static_cast<uint32_t>(report.dropped_lines));
+        reply->set_pruned_variance(report.dropped_variance);
+        reply->set_max_elevation_error(report.max_elevation_error);
+    }
+    // The entries of the previous spectrum can no longer be found (see compute_elevations_cached), nor inserted
+    cache_.clear(wave_spectrum_.publish(wave_spectrum));
+    reply->set_number_of_lines(static_cast<uint32_t>(wave_spectrum->size()));
+}
+
+// Durations are recorded in ns and sent in s (scale 1e-9)
+void set_distribution(const MetricHistogram& histogram, const double scale, Distribution* distribution);
+void set_distribution(const MetricHistogram& histogram, const double scale, Distribution* distribution)
+{
+    distribution->set_count(histogram.count());
+    distribution->set_mean(histogram.mean() * scale);
+    distribution->set_p50(static_cast<double>(histogram.percentile(50)) * scale);
+    distribution->set_p90(static_cast<double>(histogram.percentile(90)) * scale);
+    distribution->set_p99(static_cast<double>(histogram.percentile(99)) * scale);
+    distribution->set_p999(static_cast<double>(histogram.percentile(99.9)) * scale);
+    distribution->set_max(static_cast<double>(histogram.max()) * scale);
+}
+
+void ElevationHandlers::get_server_stats(const ServerStatsRequest& request, ServerStatsResponse* reply)
+{
+    const ResponseRecorder recorder(metrics_, Rpc::GET_SERVER_STATS, request, 0, *reply);
+    reply->Clear();
+    reply->set_uptime(metrics_.uptime());
+    for (size_t index = 0; index < static_cast<size_t>(Rpc::NUMBER_OF_RPCS); ++index)
+    {
+        const Rpc rpc = static_cast<Rpc>(index);
+        const RpcMetrics& rpc_metrics = metrics_.rpc(rpc);
+        if (rpc_metrics.calls == 0)
+        {
+            continue;
+        }
+        RpcStats* rpc_stats = reply->add_rpcs();
+        rpc_stats->set_method(to_string(rpc));
+        rpc_stats->set_calls(rpc_metrics.calls);
+        rpc_stats->set_errors(rpc_metrics.errors);
+        rpc_stats->set_messages(rpc_metrics.messages);
+        set_distribution(rpc_metrics.compute_time, 1e-9, rpc_stats->mutable_compute_time());
+        set_distribution(rpc_metrics.reply_time, 1e-9, rpc_stats->mutable_reply_time());
+        set_distribution(rpc_metrics.points, 1, rpc_stats->mutable_points());
+        set_distribution(rpc_metrics.request_bytes, 1, rpc_stats->mutable_request_bytes());
+        set_distribution(rpc_metrics.response_bytes, 1, rpc_stats->mutable_response_bytes());
+    }
+    // Including this call
+    reply->set_in_flight_calls(static_cast<uint64_t>(std::max(metrics_.in_flight_calls(), int64_t(0))));
+    reply->set_in_flight_bytes(static_cast<uint64_t>(std::max(metrics_.in_flight_bytes(), int64_t(0))));
+    reply->set_active_streams(static_cast<uint64_t>(std::max(metrics_.active_streams(), int64_t(0))));
+    reply->set_cache_hits(cache_.hits());
+    reply->set_cache_misses(cache_.misses());
+    reply->set_cache_size_in_bytes(cache_.size_in_bytes());
+    reply->set_batches(batcher_.batches());
+    reply->set_batched_requests(batcher_.batched_requests());
+}
+
+void ElevationHandlers::compute_elevations_cached(const double* x, const double* y, const size_t n, const double t, double* z)
+{
+    // The version goes with the spectrum: a request started before a SetWaveSpectrum
+    // cannot insert elevations of the previous spectrum under the new version
+    uint64_t spectrum_version = 0;
+    const std::shared_ptr<const WaveSpectrum> wave_spectrum = wave_spectrum_.get(spectrum_version);
+    if (cache_.find(spectrum_version, t, x, y, n, z))
+    {
+        return;
+    }
+    batcher_.compute(spectrum_version, wave_spectrum, t, x, y, n, z);
+    cache_.insert(spectrum_version, t, x, y, n, z);
+}
+
+void ElevationHandlers::get_elevation(const ElevationRequest& request, ElevationResponse* reply)
+{
+    const ResponseRecorder recorder(metrics_, Rpc::GET_ELEVATION, request, static_cast<size_t>(request.points_size()), *reply);
+    reply->clear_elevation_points();
+    reply->set_t(request.t());
+    reply->mutable_elevation_points()->Reserve(request.points_size());
+    for (const Point& point : request.points())
+    {
+        ElevationPoint* added_elevation_point = reply->add_elevation_points();
+        added_elevation_point->set_x(point.x());
+        added_elevation_point->set_y(point.y());
+        added_elevation_point->set_z(point.x() + point.y());
+    }
+}
+
+// The points of a request are given by two lists: a missing coordinate is an error, not a shorter request
+void check_same_size(const size_t x_size, const size_t y_size);
+void check_same_size(const size_t x_size, const size_t y_size)
+{
+    if (x_size != y_size)
+    {
+        throw std::invalid_argument("x and y should have the same size");
+    }
+}
+
+void ElevationHandlers::get_elevation_input_repeated(const ElevationRequestRepeated& request, ElevationResponse* reply)
+{
+    const ResponseRecorder recorder(metrics_, Rpc::GET_ELEVATION_INPUT_REPEATED, request, static_cast<size_t>(request.x_size()), *reply);
+    check_same_size(static_cast<size_t>(request.x_size()), static_cast<size_t>(request.y_size()));
+    reply->clear_elevation_points();
+    reply->set_t(request.t());
+    reply->mutable_elevation_points()->Reserve(request.x_size());
+    for (int index = 0; index < request.x_size(); ++index)
+    {
+        ElevationPoint* added_elevation_point = reply->add_elevation_points();
+        added_elevation_point->set_x(request.x(index));
+        added_elevation_point->set_y(request.y(index));
+        added_elevation_point->set_z(request.x(index) + request.y(index));
+    }
+}
+
+void ElevationHandlers::get_elevation_output_repeated(const ElevationRequest& request, ElevationResponseRepeated* reply)
+{
+    const ResponseRecorder recorder(metrics_, Rpc::GET_ELEVATION_OUTPUT_REPEATED, request, static_cast<size_t>(request.points_size()), *reply);
+    reply->clear_z();
+    reply->clear_x(); reply->clear_y();
+    reply->set_t(request.t());
+    reply->mutable_x()->Reserve(request.points_size());
+    reply->mutable_y()->Reserve(request.points_size());
+    reply->mutable_z()->Reserve(request.points_size());
+    for (const Point& point : request.points())
+    {
+        reply->add_x(point.x());
+        reply->add_y(point.y());
+        reply->add_z(point.x() + point.y());
+    }
+}
+
+void ElevationHandlers::get_elevation_repeated(const ElevationRequestRepeated& request, ElevationResponseRepeated* reply)
+{
+    const ResponseRecorder recorder(metrics_, Rpc::GET_ELEVATION_REPEATED, request, static_cast<size_t>(request.x_size()), *reply);
+    check_same_size(static_cast<size_t>(request.x_size()), static_cast<size_t>(request.y_size()));
+    reply->clear_z();
+    reply->clear_x(); reply->clear_y();
+    reply->set_t(request.t());
+    const int size = request.x_size();
+    reply->mutable_x()->Resize(size, 0.0);
+    reply->mutable_y()->Resize(size, 0.0);
+    std::copy(request.x().data(), request.x().data() + size, reply->mutable_x()->mutable_data());
+    std::copy(request.y().data(), request.y().data() + size, reply->mutable_y()->mutable_data());
+    reply->mutable_z()->Resize(size, 0.0);
+    compute_elevations_cached(request.x().data(), request.y().data(), size, request.t(), reply->mutable_z()->mutable_data());
+}
+
+void ElevationHandlers::get_elevation_output_repeated_z(const ElevationRequest& request, ElevationResponseRepeated* reply)
+{
+    const ResponseRecorder recorder(metrics_, Rpc::GET_ELEVATION_OUTPUT_REPEATED_Z, request, static_cast<size_t>(request.points_size()), *reply);
+    reply->clear_z();
+    reply->set_t(request.t());
+    reply->mutable_z()->Reserve(request.points_size());
+    for (const Point& point : request.points())
+    {
+        reply->add_z(point.x() + point.y());
+    }
+}
+
+void ElevationHandlers::get_elevation_repeated_z(const ElevationRequestRepeated& request, ElevationResponseRepeated* reply)
+{
+    const ResponseRecorder recorder(metrics_, Rpc::GET_ELEVATION_REPEATED_Z, request, static_cast<size_t>(request.x_size()), *reply);
+    check_same_size(static_cast<size_t>(request.x_size()), static_cast<size_t>(request.y_size()));
+    reply->clear_z();
+    reply->set_t(request.t());
+    const int size = request.x_size();
+    reply->mutable_z()->Resize(size, 0.0);
+    compute_elevations_cached(request.x().data(), request.y().data(), size, request.t(), reply->mutable_z()->mutable_data());
+}
+
+void ElevationHandlers::get_elevation_repeated_float(const ElevationRequestRepeated& request, ElevationResponseRepeatedFloat* reply)
+{
+    const ResponseRecorder recorder(metrics_, Rpc::GET_ELEVATION_REPEATED_FLOAT, request, static_cast<size_t>(request.x_size()), *reply);
+    check_same_size(static_cast<size_t>(request.x_size()), static_cast<size_t>(request.y_size()));
+    reply->clear_z();
+    reply->set_t(request.t());
+    const int size = request.x_size();
+    const std::vector<float> x(request.x().data(), request.x().data() + size);
+    const std::vector<float> y(request.y().data(), request.y().data() + size);
+    const SinglePrecisionLines lines(*wave_spectrum(), request.t());
+    reply->mutable_z()->Resize(size, 0.0f);
+    compute_elevations_float(x.data(), y.data(), x.size(), lines, reply->mutable_z()->mutable_data(), pool_);
+}
+
+void ElevationHandlers::get_elevation_grid(const ElevationRequestGrid& request, ElevationResponseRepeated* reply)
+{
+    const ResponseRecorder recorder(metrics_, Rpc::GET_ELEVATION_GRID, request, static_cast<size_t>(request.nx()) * request.ny(), *reply);
+    const size_t nx = request.nx();
+    const size_t ny = request.ny();
+    if (nx * ny > ELEVATION_GRID_MAX_POINTS)
+    {
+        throw std::invalid_argument("the grid should have at most " + std::to_string(ELEVATION_GRID_MAX_POINTS) + " points");
+    }
+    reply->clear_z();
+    reply->set_t(request.t());
+    reply->mutable_z()->Resize(static_cast<int>(nx * ny), 0.0);
+    compute_grid_elevations(request.x0(), request.dx(), nx, request.y0(), request.dy(), ny, request.t(),
+                            *wave_spectrum(), reply->mutable_z()->mutable_data(), pool_);
+}
+
+void ElevationHandlers::get_elevation_snapshot(const ElevationRequestSnapshot& request, ElevationResponseSnapshot* reply)
+{
+    const ElevationRequestGrid& grid = request.grid();
+    const size_t number_of_points = request.x_size() > 0 ? static_cast<size_t>(request.x_size()) : static_cast<size_t>(grid.nx()) * grid.ny();
+    const ResponseRecorder recorder(metrics_, Rpc::GET_ELEVATION_SNAPSHOT, request, number_of_points, *reply);
+    if (static_cast<size_t>(grid.nx()) * grid.ny() > ELEVATION_GRID_MAX_POINTS)
+    {
+        throw std::invalid_argument("the grid should have at most " + std::to_string(ELEVATION_GRID_MAX_POINTS) + " points");
+    }
+    if (request.x_size() != request.y_size())
+    {
+        throw std::invalid_argument("x and y should have the same size");
+    }
+    const WaveFieldSnapshot snapshot(*wave_spectrum(), grid.x0(), grid.dx(), grid.nx(), grid.y0(), grid.dy(), grid.ny(), grid.t(), pool_);
+    reply->clear_z();
+    reply->set_t(grid.t());
+    if (request.x_size() == 0)
+    {
+        reply->mutable_z()->Reserve(static_cast<int>(snapshot.z().size()));
+        for (const double z : snapshot.z())
+        {
+            reply->add_z(z);
+        }
+        reply->set_error_bound(snapshot.synthesis_error_bound());
+        return;
+    }
+    reply->mutable_z()->Resize(request.x_size(), 0.0);
+    double* z = reply->mutable_z()->mutable_data();
+    for (int index = 0; index < request.x_size(); ++index)
+    {
+        z[index] = snapshot.interpolate(request.x(index), request.y(index));
+    }
+    reply->set_error_bound(snapshot.interpolation_error_bound());
+}
+
+void ElevationHandlers::get_elevation_times(const ElevationRequestTimes& request, ElevationResponseTimes* reply)
+{
+    const ResponseRecorder recorder(metrics_, Rpc::GET_ELEVATION_TIMES, request, static_cast<size_t>(request.x_size()), *reply);
+    check_same_size(static_cast<size_t>(request.x_size()), static_cast<size_t>(request.y_size()));
+    const size_t size = static_cast<size_t>(request.x_size());
+    const size_t number_of_times = static_cast<size_t>(request.t_size());
+    if (size * number_of_times > ELEVATION_TIMES_MAX_VALUES)
+    {
+        throw std::invalid_argument("there should be at most " + std::to_string(ELEVATION_TIMES_MAX_VALUES) + " elevations (points x times)");
+    }
+    reply->clear_z();
+    *reply->mutable_t() = request.t();
+    reply->set_number_of_points(static_cast<uint32_t>(size));
+    reply->mutable_z()->Resize(static_cast<int>(size * number_of_times), 0.0);
+    compute_elevations_at_times(request.x().data(), request.y().data(), size, request.t().data(), number_of_times,
+                                *wave_spectrum(), reply->mutable_z()->mutable_data(), pool_);
+}
+
+void ElevationHandlers::get_elevation_shared(const ElevationRequestShared& request, ElevationResponseShared* reply)
+{
+    const size_t size = static_cast<size_t>(request.number_of_points());
+    const ResponseRecorder recorder(metrics_, Rpc::GET_ELEVATION_SHARED, request, size, *reply);
+    SharedPoints points(request.segment(), request.token(), size);
+    compute_elevations_cached(points.x(), points.y(), points.size(), request.t(), points.z());
+    points.write_z();
+    reply->set_t(request.t());
+    reply->set_number_of_points(request.number_of_points());
+}
+
+void ElevationHandlers::compute_packed_elevations(const ElevationRequestPacked& request, ElevationResponsePacked* reply)
+{
+    reply->set_t(request.t());
+    reply->set_encoding(request.encoding());
+    const size_t size = number_of_packed_values(request.x(), request.encoding());
+    check_same_size(size, number_of_packed_values(request.y(), request.encoding()));
+    std::vector<double> x_buffer, y_buffer;
+    const double* x = unpack_values(request.x(), size, request.encoding(), x_buffer);
+    const double* y = unpack_values(request.y(), size, request.encoding(), y_buffer);
+    std::vector<double> z(size);
+    compute_elevations_cached(x, y, size, request.t(), z.data());
+    pack_values(z.data(), size, request.encoding(), reply->mutable_z());
+}
+
+void ElevationHandlers::get_elevation_packed(const ElevationRequestPacked& request, ElevationResponsePacked* reply)
+{
+    const ResponseRecorder recorder(metrics_, Rpc::GET_ELEVATION_PACKED, request, number_of_packed_values(request.x(), request.encoding()), *reply);
+    compute_packed_elevations(request, reply);
+    const size_t size = number_of_packed_values(reply->z(), request.encoding()) * packed_value_size(request.encoding());
+    reply->set_x(request.x().data(), size);
+    reply->set_y(request.y().data(), size);
+}
+
+void ElevationHandlers::get_elevation_packed_z(const ElevationRequestPacked& request, ElevationResponsePacked* reply)
+{
+    const ResponseRecorder recorder(metrics_, Rpc::GET_ELEVATION_PACKED_Z, request, number_of_packed_values(request.x(), request.encoding()), *reply);
+    reply->clear_x(); reply->clear_y();
+    compute_packed_elevations(request, reply);
+}
+
+ElevationStream::ElevationStream(ElevationHandlers& handlers, const ElevationRequest& request):
+    handlers_(handlers), recorder_(handlers.metrics(), Rpc::GET_ELEVATIONS), wave_spectrum_(handlers.wave_spectrum()), request_(request),
+    x_(), y_(), z_(), recurrence_(), count_(-1), index_(0), first_point_(0)
+{
+    handlers.metrics().record_request(Rpc::GET_ELEVATIONS, request, static_cast<size_t>(request.points_size()));
+    const size_t number_of_points = static_cast<size_t>(request.points_size());
+    const bool splits_time_steps = request.max_points_per_message() > 0 && request.max_points_per_message() < number_of_points;
+    if (not(splits_time_steps) && request.time_steps_per_message() > 1
+        && request.time_steps_per_message() > ELEVATION_STREAM_MAX_MESSAGE_POINTS / std::max(number_of_points, size_t(1)))
+    {
+        throw std::invalid_argument("a message should hold at most " + std::to_string(ELEVATION_STREAM_MAX_MESSAGE_POINTS)
+                                    + " elevations (time steps per message x points)");
+    }
+    if (request.dt() > 0 && request.t_end() - request.t_start() > 0)
+    {
+        for (const Point& point : request.points())
+        {
+            x_.push_back(point.x());
+            y_.push_back(point.y());
+        }
+        z_.resize(x_.size());
+        if (request.resynchronisation_period() > 0 && ElevationRecurrence::fits(*wave_spectrum_, x_.size()))
+        {
+            recurrence_.reset(new ElevationRecurrence(*wave_spectrum_, x_, y_, request.t_start(), request.dt(), request.resynchronisation_period()));
+        }
+        count_ = (request.t_end() - request.t_start()) / request.dt();
+    }
+}
+
+void ElevationStream::compute(const size_t index)
+{
+    if (recurrence_)
+    {
+        recurrence_->next(z_.data());
+    }
+    else
+    {
+        compute_elevations(x_.data(), y_.data(), x_.size(), time_step(index), *wave_spectrum_, z_.data(), handlers_.pool());
+    }
+}
+
+void ElevationStream::add_points(const size_t begin, const size_t end, ElevationResponse* response) const
+{
+    for (size_t point_index = begin; point_index < end; ++point_index)
+    {
+        ElevationPoint* added_elevation_point = response->add_elevation_points();
+        added_elevation_point->set_x(x_[point_index]);
+        added_elevation_point->set_y(y_[point_index]);
+        added_elevation_point->set_z(z_[point_index]);
+    }
+}
+
+bool ElevationStream::next(ElevationResponse* response)
+{
+    if (index_ > count_)
+    {
+        return false;
+    }
+    const ResponseRecorder recorder(handlers_.metrics(), Rpc::GET_ELEVATIONS, *response);
+    response->clear_elevation_points();
+    response->clear_time_steps();
+    response->set_t(time_step(index_));
+    const size_t number_of_points = x_.size();
+    const size_t points_per_message = request_.max_points_per_message();
+    if (points_per_message > 0 && points_per_message < number_of_points)
+    {
+        if (first_point_ == 0)
+        {
+            compute(index_);
+        }
+        const size_t end = std::min(first_point_ + points_per_message, number_of_points);
+        response->add_time_steps(time_step(index_));
+        response->set_first_point(static_cast<uint32_t>(first_point_));
+        response->mutable_elevation_points()->Reserve(static_cast<int>(end - first_point_));
+        add_points(first_point_, end, response);
+        first_point_ = end;
+        if (first_point_ == number_of_points)
+        {
+            first_point_ = 0;
+            ++index_;
+        }
+        return true;
+    }
+    const size_t time_steps_per_message = std::max(request_.time_steps_per_message(), 1u);
+    response->set_first_point(0);
+    response->mutable_elevation_points()->Reserve(static_cast<int>(std::min(time_steps_per_message, size_t(count_ - index_) + 1) * number_of_points));
+    for (size_t step = 0; step < time_steps_per_message && index_ <= count_; ++step)
+    {
+        compute(index_);
+        response->add_time_steps(time_step(index_));
+        add_points(0, number_of_points, response);
+        ++index_;
+    }
+    return true;
+}
+
+PointSetSession::PointSetSession(ElevationHandlers& handlers):
+    handlers_(handlers), recorder_(handlers.metrics(), Rpc::ELEVATION_SESSION), x_(), y_(), has_points_(false)
+{
+}
+
+void PointSetSession::next(const ElevationSessionRequest& request, ElevationResponseRepeated* reply)
+{
+    const size_t number_of_points = request.x_size() > 0 ? static_cast<size_t>(request.x_size()) : x_.size();
+    const ResponseRecorder recorder(handlers_.metrics(), Rpc::ELEVATION_SESSION, request, number_of_points, *reply);
+    if (request.x_size() > 0 || request.y_size() > 0)
+    {
+        if (request.x_size() != request.y_size())
+        {
+            throw std::invalid_argument("x and y should have the same size");
+        }
+        x_.assign(request.x().begin(), request.x().end());
+        y_.assign(request.y().begin(), request.y().end());
+        has_points_ = true;
+    }
+    if (not(has_points_))
+    {
+        throw std::invalid_argument("the first message of the session should contain the point set (x, y)");
+    }
+    if (request.dx_size() > 0 || request.dy_size() > 0)
+    {
+        if (request.dx_size() != static_cast<int>(x_.size()) || request.dy_size() != static_cast<int>(y_.size()))
+        {
+            throw std::invalid_argument("dx and dy should have the same size as the point set");
+        }
+        for (size_t index = 0; index < x_.size(); ++index)
+        {
+            x_[index] += request.dx(static_cast<int>(index));
+            y_[index] += request.dy(static_cast<int>(index));
+        }
+    }
+    reply->clear_x(); reply->clear_y();
+    reply->set_t(request.t());
+    reply->mutable_z()->Resize(static_cast<int>(x_.size()), 0.0);
+    compute_elevations(x_.data(), y_.data(), x_.size(), request.t(), *handlers_.wave_spectrum(), reply->mutable_z()->mutable_data(), handlers_.pool());
+}
@@ -0,0 +1,138 @@
+#ifndef ELEVATION_HANDLERS_HH
+#define ELEVATION_HANDLERS_HH
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "elevation_batcher.hh"
+#include "elevation_cache.hh"
+#include "elevation_recurrence.hh"
+#include "published_pointer.hh"
+#include "server_metrics.hh"
+#include "wave_spectrum.hh"
+#include "worker_pool.hh"
+#include "wave.pb.h"
+
+// Throws std::invalid_argument if the spectrum lines are inconsistent
+WaveSpectrum to_wave_spectrum(const wave::FlatDiscreteDirectionalWaveSpectrum& wave_spectrum);
+
+// What each ElevationService RPC computes, independently of the gRPC API
+// (synchronous or asynchronous) used to serve it.
+//
+// The wave spectrum can be replaced by SetWaveSpectrum at any time: each request
+// takes the current spectrum when it starts and keeps it until it is done.
+//
+// Every request and response is recorded in metrics(), whichever server serves it.
+class ElevationHandlers
+{
+    public:
+        // Elevations of explicit point sets are cached (see ElevationCache) up to cache_capacity_in_bytes,
+        // and the small requests for the same t are computed together if they arrive within batch_window
+        // (see ElevationBatcher, 0 computes each request on its own). SetWaveSpectrum can only map the
+        // spectrum files of spectrum_directory (none if it is empty).
+        ElevationHandlers(const WaveSpectrum& wave_spectrum, WorkerPool& pool, const size_t cache_capacity_in_bytes,
+                          const std::chrono::microseconds batch_window, const std::string& spectrum_directory);
+
+        void get_elevation(const wave::ElevationRequest& request, wave::ElevationResponse* reply);
+        // The requests with lists x and y throw std::invalid_argument if they do not have the same size
+        void get_elevation_input_repeated(const wave::ElevationRequestRepeated& request, wave::ElevationResponse* reply);
+        void get_elevation_output_repeated(const wave::ElevationRequest& request, wave::ElevationResponseRepeated* reply);
+        void get_elevation_repeated(const wave::ElevationRequestRepeated& request, wave::ElevationResponseRepeated* reply);
+        void get_elevation_output_repeated_z(const wave::ElevationRequest& request, wave::ElevationResponseRepeated* reply);
+        void get_elevation_repeated_z(const wave::ElevationRequestRepeated& request, wave::ElevationResponseRepeated* reply);
+        // Single precision (see SinglePrecisionLines), not cached
+        void get_elevation_repeated_float(const wave::ElevationRequestRepeated& request, wave::ElevationResponseRepeatedFloat* reply);
+        void get_elevation_packed(const wave::ElevationRequestPacked& request, wave::ElevationResponsePacked* reply);
+        void get_elevation_packed_z(const wave::ElevationRequestPacked& request, wave::ElevationResponsePacked* reply);
+        // Throws std::invalid_argument if the grid has more than ELEVATION_GRID_MAX_POINTS points
+        void get_elevation_grid(const wave::ElevationRequestGrid& request, wave::ElevationResponseRepeated* reply);
+        // Throws std::invalid_argument if the grid is invalid (see WaveFieldSnapshot) or a point is outside of it
+        void get_elevation_snapshot(const wave::ElevationRequestSnapshot& request, wave::ElevationResponseSnapshot* reply);
+        // Throws std::invalid_argument if there are more than ELEVATION_TIMES_MAX_VALUES elevations to compute
+        void get_elevation_times(const wave::ElevationRequestTimes& request, wave::ElevationResponseTimes* reply);
+        // Computes from and into the shared memory segment of the client (see SharedPoints), cached as GetElevationRepeatedZ.
+        // Throws std::invalid_argument if the segment cannot be mapped, does not match the request or is shrunk meanwhile.
+        void get_elevation_shared(const wave::ElevationRequestShared& request, wave::ElevationResponseShared* reply);
+        // Throws std::invalid_argument if the new spectrum is empty or inconsistent, if the pruning
+        // threshold is not in [0, 1[, or if the file is not a relative path without '..' to a valid
+        // spectrum file of the spectrum directory (the current spectrum is then kept)
+        void set_wave_spectrum(const wave::SetWaveSpectrumRequest& request, wave::SetWaveSpectrumResponse* reply);
+        // What metrics() recorded since the server started, and the counters of the cache and batcher
+        void get_server_stats(const wave::ServerStatsRequest& request, wave::ServerStatsResponse* reply);
+
+        // Current spectrum, never null. Lock free: can be called for each request.
+        std::shared_ptr<const WaveSpectrum> wave_spectrum() const {return wave_spectrum_.get();}
+        WorkerPool& pool() {return pool_;}
+        const ElevationCache& cache() const {return cache_;}
+        const ElevationBatcher& batcher() const {return batcher_;}
+        ServerMetrics& metrics() {return metrics_;}
+
+    private:
+        void compute_elevations_cached(const double* x, const double* y, const size_t n, const double t, double* z);
+        void compute_packed_elevations(const wave::ElevationRequestPacked& request, wave::ElevationResponsePacked* reply);
+
+        PublishedPointer<const WaveSpectrum> wave_spectrum_;
+        const std::string spectrum_directory_;
+        WorkerPool& pool_;
+        ElevationCache cache_;
+        ElevationBatcher batcher_;
+        ServerMetrics metrics_;
+};
+
+// Largest number of points of a GetElevations message holding several time steps (time steps x points)
+#define ELEVATION_STREAM_MAX_MESSAGE_POINTS (size_t(1) << 20)
+
+// Successive messages of the GetElevations stream, for the time steps between t_start and t_end:
+// by default one per time step, or time_steps_per_message time steps per message, or each time
+// step split in messages of max_points_per_message points (see ElevationRequest).
+class ElevationStream
+{
+    public:
+        // request must outlive the stream.
+        // Throws std::invalid_argument if time_steps_per_message (when used) times the number of points
+        // is more than ELEVATION_STREAM_MAX_MESSAGE_POINTS.
+        ElevationStream(ElevationHandlers& handlers, const wave::ElevationRequest& request);
+
+        // Fills response with the next message. Returns false once all time steps have been sent.
+        bool next(wave::ElevationResponse* response);
+
+    private:
+        double time_step(const size_t index) const {return request_.t_start() + index * request_.dt();}
+        void compute(const size_t index);    //!< Elevations of the time step index in z_ (the time steps are computed in order)
+        void add_points(const size_t begin, const size_t end, wave::ElevationResponse* response) const;
+
+        ElevationHandlers& handlers_;
+        const StreamRecorder recorder_;
+        const std::shared_ptr<const WaveSpectrum> wave_spectrum_;  //!< The same for the whole stream
+        const wave::ElevationRequest& request_;
+        std::vector<double> x_;
+        std::vector<double> y_;
+        std::vector<double> z_;
+        std::unique_ptr<ElevationRecurrence> recurrence_;
+        double count_;
+        size_t index_;
+        size_t first_point_;    //!< Next point to send when a time step is split across messages
+};
+
+// Point set of an ElevationSession stream, kept from one message to the next.
+class PointSetSession
+{
+    public:
+        explicit PointSetSession(ElevationHandlers& handlers);
+
+        // Updates the point set as described by request, then computes its elevations at request.t()
+        // with the current wave spectrum.
+        // Throws std::invalid_argument if request is inconsistent with the point set.
+        void next(const wave::ElevationSessionRequest& request, wave::ElevationResponseRepeated* reply);
+
+    private:
+        ElevationHandlers& handlers_;
+        const StreamRecorder recorder_;
+        std::vector<double> x_;
+        std::vector<double> y_;
+        bool has_points_;
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include <cmath>
+#include "elevation_kernel.hh"
+
+double compute_elevation(const double x, const double y, const double t, const WaveSpectrum& wave_spectrum)
+{
+    const double* a = wave_spectrum.a();
+    const double* k_cos_psi = wave_spectrum.k_cos_psi();
+    const double* k_sin_psi = wave_spectrum.k_sin_psi();
+    const double* omega = wave_spectrum.omega();
+    const double* phase = wave_spectrum.phase();
+    const size_t size = wave_spectrum.size();
+
+    double result = 0;
+    for (size_t index = 0; index < size; ++index)
+    {
+        result += - a[index] * sin(x * k_cos_psi[index] + y * k_sin_psi[index] - omega[index] * t + phase[index]);
+    }
+    return result;
+}
+
+void compute_elevations_scalar(const double* x, const double* y, const size_t n, const double t, const WaveSpectrum& wave_spectrum, double* z)
+{
+    for (size_t index = 0; index < n; ++index)
+    {
+        z[index] = compute_elevation(x[index], y[index], t, wave_spectrum);
+    }
+}
+
+void compute_sin_cos_scalar(const double* theta, const size_t n, double* sin_theta, double* cos_theta)
+{
+    for (size_t index = 0; index < n; ++index)
+    {
+        sin_theta[index] = sin(theta[index]);
+        cos_theta[index] = cos(theta[index]);
+    }
+}
+
+#ifndef WAVE_X86_KERNELS
+void compute_elevations_avx2(const double* x, const double* y, const size_t n, const double t, const WaveSpectrum& wave_spectrum, double* z)
+{
+    compute_elevations_scalar(x, y, n, t, wave_spectrum, z);
+}
+
+void compute_elevations_avx512(const double* x, const double* y, const size_t n, const double t, const WaveSpectrum& wave_spectrum, double* z)
+{
+    compute_elevations_scalar(x, y, n, t, wave_spectrum, z);
+}
+
+void compute_sin_cos_avx2(const double* theta, const size_t n, double* sin_theta, double* cos_theta)
+{
+    compute_sin_cos_scalar(theta, n, sin_theta, cos_theta);
+}
+
+void compute_sin_cos_avx512(const double* theta, const size_t n, double* sin_theta, double* cos_theta)
+{
+    compute_sin_cos_scalar(theta, n, sin_theta, cos_theta);
+}
+
+void compute_elevations_float_avx2(const float* x, const float* y, const size_t n, const SinglePrecisionLines& lines, float* z)
+{
+    compute_elevations_float_scalar(x, y, n, lines, z);
+}
+
+void compute_elevations_float_avx512(const float* x, const float* y, const size_t n, const SinglePrecisionLines& lines, float* z)
+{
+    compute_elevations_float_scalar(x, y, n, lines, z);
+}
+#endif
+
+SinglePrecisionLines::SinglePrecisionLines(const WaveSpectrum& wave_spectrum, const double t):
+    a(wave_spectrum.a(), wave_spectrum.a() + wave_spectrum.size()),
+    k_cos_psi(wave_spectrum.k_cos_psi(), wave_spectrum.k_cos_psi() + wave_spectrum.size()),
+    k_sin_psi(wave_spectrum.k_sin_psi(), wave_spectrum.k_sin_psi() + wave_spectrum.size()),
+    phase_t(wave_spectrum.size())
+{
+    const double two_pi = 8 * std::atan(1.0);
+    for (size_t line = 0; line < wave_spectrum.size(); ++line)
+    {
+        phase_t[line] = static_cast<float>(std::remainder(wave_spectrum.phase()[line] - wave_spectrum.omega()[line] * t, two_pi));
+    }
+}
+
+void compute_elevations_float_scalar(const float* x, const float* y, const size_t n, const SinglePrecisionLines& lines, float* z)
+{
+    const size_t size = lines.size();
+    for (size_t index = 0; index < n; ++index)
+    {
+        float result = 0;
+        for (size_t line = 0; line < size; ++line)
+        {
+            result -= lines.a[line] * std::sin(x[index] * lines.k_cos_psi[line] + y[index] * lines.k_sin_psi[line] + lines.phase_t[line]);
+        }
+        z[index] = result;
+    }
+}
+
+ElevationKernelIsa best_elevation_kernel_isa()
+{
+#ifdef WAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return ElevationKernelIsa::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        return ElevationKernelIsa::AVX2;
+    }
+#endif
+    return ElevationKernelIsa::SCALAR;
+}
+
+const char* to_string(const ElevationKernelIsa isa)
+{
+    switch (isa)
+    {
+        case ElevationKernelIsa::AVX512: return "avx512";
+        case ElevationKernelIsa::AVX2: return "avx2";
+        case ElevationKernelIsa::SCALAR: return "scalar";
+    }
+    return "unknown";
+}
+
+typedef void (*ElevationKernel)(const double*, const double*, const size_t, const double, const WaveSpectrum&, double*);
+
+ElevationKernel select_elevation_kernel();
+ElevationKernel select_elevation_kernel()
+{
+    switch (best_elevation_kernel_isa())
+    {
+        case ElevationKernelIsa::AVX512: return compute_elevations_avx512;
+        case ElevationKernelIsa::AVX2: return compute_elevations_avx2;
+        case ElevationKernelIsa::SCALAR: return compute_elevations_scalar;
+    }
+    return compute_elevations_scalar;
+}
+
+void compute_elevations(const double* x, const double* y, const size_t n, const double t, const WaveSpectrum& wave_spectrum, double* z)
+{
+    static const ElevationKernel kernel = select_elevation_kernel();
+    kernel(x, y, n, t, wave_spectrum, z);
+}
+
+typedef void (*SinCosKernel)(const double*, const size_t, double*, double*);
+
+SinCosKernel select_sin_cos_kernel();
+SinCosKernel select_sin_cos_kernel()
+{
+    switch (best_elevation_kernel_isa())
+    {
+        case ElevationKernelIsa::AVX512: return compute_sin_cos_avx512;
+        case ElevationKernelIsa::AVX2: return compute_sin_cos_avx2;
+        case ElevationKernelIsa::SCALAR: return compute_sin_cos_scalar;
+    }
+    return compute_sin_cos_scalar;
+}
+
+void compute_sin_cos(const double* theta, const size_t n, double* sin_theta, double* cos_theta)
+{
+    static const SinCosKernel kernel = select_sin_cos_kernel();
+    kernel(theta, n, sin_theta, cos_theta);
+}
+
+typedef void (*FloatElevationKernel)(const float*, const float*, const size_t, const SinglePrecisionLines&, float*);
+
+FloatElevationKernel select_float_elevation_kernel();
+FloatElevationKernel select_float_elevation_kernel()
+{
+    switch (best_elevation_kernel_isa())
+    {
+        case ElevationKernelIsa::AVX512: return compute_elevations_float_avx512;
+        case ElevationKernelIsa::AVX2: return compute_elevations_float_avx2;
+        case ElevationKernelIsa::SCALAR: return compute_elevations_float_scalar;
+    }
+    return compute_elevations_float_scalar;
+}
+
+void compute_elevations_float(const float* x, const float* y, const size_t n, const SinglePrecisionLines& lines, float* z)
+{
+    static const FloatElevationKernel kernel = select_float_elevation_kernel();
+    kernel(x, y, n, lines, z);
+}
@@ -0,0 +1,77 @@
+#ifndef ELEVATION_KERNEL_HH
+#define ELEVATION_KERNEL_HH
+
+#include <cstddef>
+#include <vector>
+#include "wave_spectrum.hh"
+
+// Wave elevation at (x, y, t): sum over the spectrum lines of
+// -a.sin(k.(x.cos(psi) + y.sin(psi)) - omega.t + phase)
+double compute_elevation(const double x, const double y, const double t, const WaveSpectrum& wave_spectrum);
+
+// Batch elevation kernels: z[i] = compute_elevation(x[i], y[i], t, wave_spectrum) for i in [0, n).
+//
+// The vectorized kernels process several points per register and evaluate the
+// sine with a polynomial after a Cody-Waite reduction modulo pi/2. The phase of
+// each line is computed with exactly the same operations as compute_elevation,
+// so the only difference with the scalar path comes from the sine itself:
+// each sine is within 2 ULP of std::sin, which bounds the difference on the
+// elevation by 2^-51.sum(|a|) (about 1e-15 m for the 128 line spectrum).
+// Phases larger than ELEVATION_KERNEL_MAX_REDUCED_PHASE (in absolute value)
+// fall back to std::sin.
+#define ELEVATION_KERNEL_MAX_REDUCED_PHASE 1.0e6
+
+enum class ElevationKernelIsa
+{
+    SCALAR,
+    AVX2,
+    AVX512
+};
+
+void compute_elevations_scalar(const double* x, const double* y, const size_t n, const double t, const WaveSpectrum& wave_spectrum, double* z);
+void compute_elevations_avx2(const double* x, const double* y, const size_t n, const double t, const WaveSpectrum& wave_spectrum, double* z);
+void compute_elevations_avx512(const double* x, const double* y, const size_t n, const double t, const WaveSpectrum& wave_spectrum, double* z);
+
+// Widest instruction set supported by both this build and the CPU we are running on
+ElevationKernelIsa best_elevation_kernel_isa();
+const char* to_string(const ElevationKernelIsa isa);
+
+// Batch elevation kernel, dispatched (once, at first call) to best_elevation_kernel_isa()
+void compute_elevations(const double* x, const double* y, const size_t n, const double t, const WaveSpectrum& wave_spectrum, double* z);
+
+// sin(theta[i]) and cos(theta[i]) for i in [0, n), for the algorithms that tabulate them
+// (same sine, accuracy and fallback as the elevation kernels: the reduction is shared)
+void compute_sin_cos_scalar(const double* theta, const size_t n, double* sin_theta, double* cos_theta);
+void compute_sin_cos_avx2(const double* theta, const size_t n, double* sin_theta, double* cos_theta);
+void compute_sin_cos_avx512(const double* theta, const size_t n, double* sin_theta, double* cos_theta);
+// Dispatched as compute_elevations
+void compute_sin_cos(const double* theta, const size_t n, double* sin_theta, double* cos_theta);
+
+// Single precision: twice as many points per register, for consumers that do not
+// need double precision (rendering, statistics). Only the time-dependent part of
+// the phase, -omega.t + phase, is computed in double precision and reduced to
+// [-pi, pi] before being rounded, so that large t do not cost any accuracy. The
+// error then grows with the distance to the origin, as k.(x.cos(psi) + y.sin(psi))
+// is rounded to a float: about 1e-5 m for points within 1 km on the 128 line spectrum.
+#define ELEVATION_KERNEL_FLOAT_MAX_REDUCED_PHASE 8192.0f
+
+// The spectrum at a given time, in single precision
+struct SinglePrecisionLines
+{
+    SinglePrecisionLines(const WaveSpectrum& wave_spectrum, const double t);
+    size_t size() const {return a.size();}
+
+    std::vector<float> a;
+    std::vector<float> k_cos_psi;
+    std::vector<float> k_sin_psi;
+    std::vector<float> phase_t;     //!< -omega.t + phase, reduced to [-pi, pi]
+};
+
+void compute_elevations_float_scalar(const float* x, const float* y, const size_t n, const SinglePrecisionLines& lines, float* z);
+void compute_elevations_float_avx2(const float* x, const float* y, const size_t n, const SinglePrecisionLines& lines, float* z);
+void compute_elevations_float_avx512(const float* x, const float* y, const size_t n, const SinglePrecisionLines& lines, float* z);
+
+// Dispatched as compute_elevations
+void compute_elevations_float(const float* x, const float* y, const size_t n, const SinglePrecisionLines& lines, float* z);
+
+#endif
@@ -0,0 +1,189 @@
+#ifdef WAVE_X86_KERNELS
+#include <cmath>
+#include <vector>
+#include <immintrin.h>
+#include "elevation_kernel.hh"
+#include "sin_approximation.hh"
+
+using namespace sin_approximation;
+
+// sin(r), cos(r) and q mod 4, where theta = q.pi/2 + r
+void reduce_avx2(const __m256d theta, __m256d& sin_r, __m256d& cos_r, __m256d& quadrant);
+void reduce_avx2(const __m256d theta, __m256d& sin_r, __m256d& cos_r, __m256d& quadrant)
+{
+    const __m256d q = _mm256_round_pd(_mm256_mul_pd(theta, _mm256_set1_pd(TWO_OVER_PI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_fnmadd_pd(q, _mm256_set1_pd(PIO2_1), theta);
+    r = _mm256_fnmadd_pd(q, _mm256_set1_pd(PIO2_2), r);
+    r = _mm256_fnmadd_pd(q, _mm256_set1_pd(PIO2_3), r);
+    const __m256d z = _mm256_mul_pd(r, r);
+
+    __m256d sin_poly = _mm256_fmadd_pd(z, _mm256_set1_pd(S6), _mm256_set1_pd(S5));
+    sin_poly = _mm256_fmadd_pd(z, sin_poly, _mm256_set1_pd(S4));
+    sin_poly = _mm256_fmadd_pd(z, sin_poly, _mm256_set1_pd(S3));
+    sin_poly = _mm256_fmadd_pd(z, sin_poly, _mm256_set1_pd(S2));
+    sin_poly = _mm256_fmadd_pd(z, sin_poly, _mm256_set1_pd(S1));
+    sin_r = _mm256_fmadd_pd(_mm256_mul_pd(r, z), sin_poly, r);
+
+    __m256d cos_poly = _mm256_fmadd_pd(z, _mm256_set1_pd(C6), _mm256_set1_pd(C5));
+    cos_poly = _mm256_fmadd_pd(z, cos_poly, _mm256_set1_pd(C4));
+    cos_poly = _mm256_fmadd_pd(z, cos_poly, _mm256_set1_pd(C3));
+    cos_poly = _mm256_fmadd_pd(z, cos_poly, _mm256_set1_pd(C2));
+    cos_poly = _mm256_fmadd_pd(z, cos_poly, _mm256_set1_pd(C1));
+    cos_r = _mm256_fmadd_pd(_mm256_mul_pd(z, z), cos_poly, _mm256_fnmadd_pd(_mm256_set1_pd(0.5), z, _mm256_set1_pd(1.0)));
+
+    // q mod 4, computed in double precision (exact for the q we accept)
+    quadrant = _mm256_fnmadd_pd(_mm256_set1_pd(4.0), _mm256_floor_pd(_mm256_mul_pd(q, _mm256_set1_pd(0.25))), q);
+}
+
+// sin(q.pi/2 + r)
+__m256d select_quadrant_avx2(const __m256d sin_r, const __m256d cos_r, const __m256d quadrant);
+__m256d select_quadrant_avx2(const __m256d sin_r, const __m256d cos_r, const __m256d quadrant)
+{
+    const __m256d odd = _mm256_fnmadd_pd(_mm256_set1_pd(2.0), _mm256_floor_pd(_mm256_mul_pd(quadrant, _mm256_set1_pd(0.5))), quadrant);
+    const __m256d use_cos = _mm256_cmp_pd(odd, _mm256_set1_pd(1.0), _CMP_EQ_OQ);
+    const __m256d negate = _mm256_cmp_pd(quadrant, _mm256_set1_pd(2.0), _CMP_GE_OQ);
+    const __m256d result = _mm256_blendv_pd(sin_r, cos_r, use_cos);
+    return _mm256_xor_pd(result, _mm256_and_pd(negate, _mm256_set1_pd(-0.0)));
+}
+
+__m256d sin_avx2(const __m256d theta);
+__m256d sin_avx2(const __m256d theta)
+{
+    __m256d sin_r, cos_r, quadrant;
+    reduce_avx2(theta, sin_r, cos_r, quadrant);
+    return select_quadrant_avx2(sin_r, cos_r, quadrant);
+}
+
+void compute_elevations_avx2(const double* x, const double* y, const size_t n, const double t, const WaveSpectrum& wave_spectrum, double* z)
+{
+    const size_t width = 4;
+    const size_t vectorized_n = n - n % width;
+    const size_t size = wave_spectrum.size();
+    const double* a = wave_spectrum.a();
+    const double* k_cos_psi = wave_spectrum.k_cos_psi();
+    const double* k_sin_psi = wave_spectrum.k_sin_psi();
+    const double* phase = wave_spectrum.phase();
+    std::vector<double> omega_t(size);
+    for (size_t line = 0; line < size; ++line)
+    {
+        omega_t[line] = wave_spectrum.omega()[line] * t;
+    }
+
+    const __m256d max_phase = _mm256_set1_pd(ELEVATION_KERNEL_MAX_REDUCED_PHASE);
+    const __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+    for (size_t index = 0; index < vectorized_n; index += width)
+    {
+        const __m256d x_i = _mm256_loadu_pd(x + index);
+        const __m256d y_i = _mm256_loadu_pd(y + index);
+        __m256d z_i = _mm256_setzero_pd();
+        for (size_t line = 0; line < size; ++line)
+        {
+            // Same operations (and order) as compute_elevation
+            const __m256d theta = _mm256_add_pd(
+                                    _mm256_sub_pd(
+                                        _mm256_add_pd(_mm256_mul_pd(x_i, _mm256_set1_pd(k_cos_psi[line])),
+                                                      _mm256_mul_pd(y_i, _mm256_set1_pd(k_sin_psi[line]))),
+                                        _mm256_set1_pd(omega_t[line])),
+                                    _mm256_set1_pd(phase[line]));
+            __m256d sin_theta = sin_avx2(theta);
+            if (_mm256_movemask_pd(_mm256_cmp_pd(_mm256_and_pd(theta, abs_mask), max_phase, _CMP_GT_OQ)))
+            {
+                alignas(32) double lanes[4];
+                _mm256_store_pd(lanes, theta);
+                for (size_t lane = 0; lane < width; ++lane)
+                {
+                    lanes[lane] = sin(lanes[lane]);
+                }
+                sin_theta = _mm256_load_pd(lanes);
+            }
+            z_i = _mm256_sub_pd(z_i, _mm256_mul_pd(_mm256_set1_pd(a[line]), sin_theta));
+        }
+        _mm256_storeu_pd(z + index, z_i);
+    }
+    compute_elevations_scalar(x + vectorized_n, y + vectorized_n, n - vectorized_n, t, wave_spectrum, z + vectorized_n);
+}
+
+void compute_sin_cos_avx2(const double* theta, const size_t n, double* sin_theta, double* cos_theta)
+{
+    const size_t width = 4;
+    const size_t vectorized_n = n - n % width;
+    const __m256d max_phase = _mm256_set1_pd(ELEVATION_KERNEL_MAX_REDUCED_PHASE);
+    const __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+    for (size_t index = 0; index < vectorized_n; index += width)
+    {
+        const __m256d theta_i = _mm256_loadu_pd(theta + index);
+        if (_mm256_movemask_pd(_mm256_cmp_pd(_mm256_and_pd(theta_i, abs_mask), max_phase, _CMP_GT_OQ)))
+        {
+            compute_sin_cos_scalar(theta + index, width, sin_theta + index, cos_theta + index);
+            continue;
+        }
+        __m256d sin_r, cos_r, quadrant;
+        reduce_avx2(theta_i, sin_r, cos_r, quadrant);
+        // cos(theta) = sin(theta + pi/2): next quadrant
+        __m256d next_quadrant = _mm256_add_pd(quadrant, _mm256_set1_pd(1.0));
+        next_quadrant = _mm256_sub_pd(next_quadrant, _mm256_and_pd(_mm256_cmp_pd(next_quadrant, _mm256_set1_pd(4.0), _CMP_EQ_OQ), _mm256_set1_pd(4.0)));
+        _mm256_storeu_pd(sin_theta + index, select_quadrant_avx2(sin_r, cos_r, quadrant));
+        _mm256_storeu_pd(cos_theta + index, select_quadrant_avx2(sin_r, cos_r, next_quadrant));
+    }
+    compute_sin_cos_scalar(theta + vectorized_n, n - vectorized_n, sin_theta + vectorized_n, cos_theta + vectorized_n);
+}
+
+__m256 sin_float_avx2(const __m256 theta);
+__m256 sin_float_avx2(const __m256 theta)
+{
+    const __m256 q = _mm256_round_ps(_mm256_mul_ps(theta, _mm256_set1_ps(TWO_OVER_PI_F)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_fnmadd_ps(q, _mm256_set1_ps(PIO2_1F), theta);
+    r = _mm256_fnmadd_ps(q, _mm256_set1_ps(PIO2_2F), r);
+    r = _mm256_fnmadd_ps(q, _mm256_set1_ps(PIO2_3F), r);
+    const __m256 z = _mm256_mul_ps(r, r);
+
+    __m256 sin_poly = _mm256_fmadd_ps(z, _mm256_set1_ps(S3F), _mm256_set1_ps(S2F));
+    sin_poly = _mm256_fmadd_ps(z, sin_poly, _mm256_set1_ps(S1F));
+    const __m256 sin_r = _mm256_fmadd_ps(_mm256_mul_ps(r, z), sin_poly, r);
+
+    __m256 cos_poly = _mm256_fmadd_ps(z, _mm256_set1_ps(C3F), _mm256_set1_ps(C2F));
+    cos_poly = _mm256_fmadd_ps(z, cos_poly, _mm256_set1_ps(C1F));
+    const __m256 cos_r = _mm256_fmadd_ps(_mm256_mul_ps(z, z), cos_poly, _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, _mm256_set1_ps(1.0f)));
+
+    // q mod 4 as an integer: q is exact for the phases we accept
+    const __m256i quadrant = _mm256_and_si256(_mm256_cvtps_epi32(q), _mm256_set1_epi32(3));
+    const __m256 use_cos = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+    const __m256 negate = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_srli_epi32(quadrant, 1), 31));
+    const __m256 result = _mm256_blendv_ps(sin_r, cos_r, use_cos);
+    return _mm256_xor_ps(result, negate);
+}
+
+void compute_elevations_float_avx2(const float* x, const float* y, const size_t n, const SinglePrecisionLines& lines, float* z)
+{
+    const size_t width = 8;
+    const size_t vectorized_n = n - n % width;
+    const size_t size = lines.size();
+    const __m256 max_phase = _mm256_set1_ps(ELEVATION_KERNEL_FLOAT_MAX_REDUCED_PHASE);
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    for (size_t index = 0; index < vectorized_n; index += width)
+    {
+        const __m256 x_i = _mm256_loadu_ps(x + index);
+        const __m256 y_i = _mm256_loadu_ps(y + index);
+        __m256 z_i = _mm256_setzero_ps();
+        for (size_t line = 0; line < size; ++line)
+        {
+            const __m256 theta = _mm256_fmadd_ps(x_i, _mm256_set1_ps(lines.k_cos_psi[line]),
+                                                 _mm256_fmadd_ps(y_i, _mm256_set1_ps(lines.k_sin_psi[line]), _mm256_set1_ps(lines.phase_t[line])));
+            __m256 sin_theta = sin_float_avx2(theta);
+            if (_mm256_movemask_ps(_mm256_cmp_ps(_mm256_andnot_ps(sign_mask, theta), max_phase, _CMP_GT_OQ)))
+            {
+                alignas(32) float lanes[8];
+                _mm256_store_ps(lanes, theta);
+                for (size_t lane = 0; lane < width; ++lane)
+                {
+                    lanes[lane] = std::sin(lanes[lane]);
+                }
+                sin_theta = _mm256_load_ps(lanes);
+            }
+            z_i = _mm256_fnmadd_ps(_mm256_set1_ps(lines.a[line]), sin_theta, z_i);
+        }
+        _mm256_storeu_ps(z + index, z_i);
+    }
+    compute_elevations_float_scalar(x + vectorized_n, y + vectorized_n, n - vectorized_n, lines, z + vectorized_n);
+}
+#endif
@@ -0,0 +1,187 @@
+#ifdef WAVE_X86_KERNELS
+#include <cmath>
+#include <vector>
+#include <immintrin.h>
+#include "elevation_kernel.hh"
+#include "sin_approximation.hh"
+
+using namespace sin_approximation;
+
+// sin(r), cos(r) and q mod 4, where theta = q.pi/2 + r
+void reduce_avx512(const __m512d theta, __m512d& sin_r, __m512d& cos_r, __m512d& quadrant);
+void reduce_avx512(const __m512d theta, __m512d& sin_r, __m512d& cos_r, __m512d& quadrant)
+{
+    const __m512d q = _mm512_roundscale_pd(_mm512_mul_pd(theta, _mm512_set1_pd(TWO_OVER_PI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512d r = _mm512_fnmadd_pd(q, _mm512_set1_pd(PIO2_1), theta);
+    r = _mm512_fnmadd_pd(q, _mm512_set1_pd(PIO2_2), r);
+    r = _mm512_fnmadd_pd(q, _mm512_set1_pd(PIO2_3), r);
+    const __m512d z = _mm512_mul_pd(r, r);
+
+    __m512d sin_poly = _mm512_fmadd_pd(z, _mm512_set1_pd(S6), _mm512_set1_pd(S5));
+    sin_poly = _mm512_fmadd_pd(z, sin_poly, _mm512_set1_pd(S4));
+    sin_poly = _mm512_fmadd_pd(z, sin_poly, _mm512_set1_pd(S3));
+    sin_poly = _mm512_fmadd_pd(z, sin_poly, _mm512_set1_pd(S2));
+    sin_poly = _mm512_fmadd_pd(z, sin_poly, _mm512_set1_pd(S1));
+    sin_r = _mm512_fmadd_pd(_mm512_mul_pd(r, z), sin_poly, r);
+
+    __m512d cos_poly = _mm512_fmadd_pd(z, _mm512_set1_pd(C6), _mm512_set1_pd(C5));
+    cos_poly = _mm512_fmadd_pd(z, cos_poly, _mm512_set1_pd(C4));
+    cos_poly = _mm512_fmadd_pd(z, cos_poly, _mm512_set1_pd(C3));
+    cos_poly = _mm512_fmadd_pd(z, cos_poly, _mm512_set1_pd(C2));
+    cos_poly = _mm512_fmadd_pd(z, cos_poly, _mm512_set1_pd(C1));
+    cos_r = _mm512_fmadd_pd(_mm512_mul_pd(z, z), cos_poly, _mm512_fnmadd_pd(_mm512_set1_pd(0.5), z, _mm512_set1_pd(1.0)));
+
+    // q mod 4, computed in double precision (exact for the q we accept)
+    quadrant = _mm512_fnmadd_pd(_mm512_set1_pd(4.0), _mm512_floor_pd(_mm512_mul_pd(q, _mm512_set1_pd(0.25))), q);
+}
+
+// sin(q.pi/2 + r)
+__m512d select_quadrant_avx512(const __m512d sin_r, const __m512d cos_r, const __m512d quadrant);
+__m512d select_quadrant_avx512(const __m512d sin_r, const __m512d cos_r, const __m512d quadrant)
+{
+    const __m512d odd = _mm512_fnmadd_pd(_mm512_set1_pd(2.0), _mm512_floor_pd(_mm512_mul_pd(quadrant, _mm512_set1_pd(0.5))), quadrant);
+    const __mmask8 use_cos = _mm512_cmp_pd_mask(odd, _mm512_set1_pd(1.0), _CMP_EQ_OQ);
+    const __mmask8 negate = _mm512_cmp_pd_mask(quadrant, _mm512_set1_pd(2.0), _CMP_GE_OQ);
+    const __m512d result = _mm512_mask_blend_pd(use_cos, sin_r, cos_r);
+    return _mm512_mask_sub_pd(result, negate, _mm512_setzero_pd(), result);
+}
+
+__m512d sin_avx512(const __m512d theta);
+__m512d sin_avx512(const __m512d theta)
+{
+    __m512d sin_r, cos_r, quadrant;
+    reduce_avx512(theta, sin_r, cos_r, quadrant);
+    return select_quadrant_avx512(sin_r, cos_r, quadrant);
+}
+
+void compute_elevations_avx512(const double* x, const double* y, const size_t n, const double t, const WaveSpectrum& wave_spectrum, double* z)
+{
+    const size_t width = 8;
+    const size_t vectorized_n = n - n % width;
+    const size_t size = wave_spectrum.size();
+    const double* a = wave_spectrum.a();
+    const double* k_cos_psi = wave_spectrum.k_cos_psi();
+    const double* k_sin_psi = wave_spectrum.k_sin_psi();
+    const double* phase = wave_spectrum.phase();
+    std::vector<double> omega_t(size);
+    for (size_t line = 0; line < size; ++line)
+    {
+        omega_t[line] = wave_spectrum.omega()[line] * t;
+    }
+
+    const __m512d max_phase = _mm512_set1_pd(ELEVATION_KERNEL_MAX_REDUCED_PHASE);
+    for (size_t index = 0; index < vectorized_n; index += width)
+    {
+        const __m512d x_i = _mm512_loadu_pd(x + index);
+        const __m512d y_i = _mm512_loadu_pd(y + index);
+        __m512d z_i = _mm512_setzero_pd();
+        for (size_t line = 0; line < size; ++line)
+        {
+            // Same operations (and order) as compute_elevation
+            const __m512d theta = _mm512_add_pd(
+                                    _mm512_sub_pd(
+                                        _mm512_add_pd(_mm512_mul_pd(x_i, _mm512_set1_pd(k_cos_psi[line])),
+                                                      _mm512_mul_pd(y_i, _mm512_set1_pd(k_sin_psi[line]))),
+                                        _mm512_set1_pd(omega_t[line])),
+                                    _mm512_set1_pd(phase[line]));
+            __m512d sin_theta = sin_avx512(theta);
+            if (_mm512_cmp_pd_mask(_mm512_abs_pd(theta), max_phase, _CMP_GT_OQ))
+            {
+                alignas(64) double lanes[8];
+                _mm512_store_pd(lanes, theta);
+                for (size_t lane = 0; lane < width; ++lane)
+                {
+                    lanes[lane] = sin(lanes[lane]);
+                }
+                sin_theta = _mm512_load_pd(lanes);
+            }
+            z_i = _mm512_sub_pd(z_i, _mm512_mul_pd(_mm512_set1_pd(a[line]), sin_theta));
+        }
+        _mm512_storeu_pd(z + index, z_i);
+    }
+    compute_elevations_scalar(x + vectorized_n, y + vectorized_n, n - vectorized_n, t, wave_spectrum, z + vectorized_n);
+}
+
+void compute_sin_cos_avx512(const double* theta, const size_t n, double* sin_theta, double* cos_theta)
+{
+    const size_t width = 8;
+    const size_t vectorized_n = n - n % width;
+    const __m512d max_phase = _mm512_set1_pd(ELEVATION_KERNEL_MAX_REDUCED_PHASE);
+    for (size_t index = 0; index < vectorized_n; index += width)
+    {
+        const __m512d theta_i = _mm512_loadu_pd(theta + index);
+        if (_mm512_cmp_pd_mask(_mm512_abs_pd(theta_i), max_phase, _CMP_GT_OQ))
+        {
+            compute_sin_cos_scalar(theta + index, width, sin_theta + index, cos_theta + index);
+            continue;
+        }
+        __m512d sin_r, cos_r, quadrant;
+        reduce_avx512(theta_i, sin_r, cos_r, quadrant);
+        // cos(theta) = sin(theta + pi/2): next quadrant
+        __m512d next_quadrant = _mm512_add_pd(quadrant, _mm512_set1_pd(1.0));
+        next_quadrant = _mm512_mask_sub_pd(next_quadrant, _mm512_cmp_pd_mask(next_quadrant, _mm512_set1_pd(4.0), _CMP_EQ_OQ),
+                                           next_quadrant, _mm512_set1_pd(4.0));
+        _mm512_storeu_pd(sin_theta + index, select_quadrant_avx512(sin_r, cos_r, quadrant));
+        _mm512_storeu_pd(cos_theta + index, select_quadrant_avx512(sin_r, cos_r, next_quadrant));
+    }
+    compute_sin_cos_scalar(theta + vectorized_n, n - vectorized_n, sin_theta + vectorized_n, cos_theta + vectorized_n);
+}
+
+__m512 sin_float_avx512(const __m512 theta);
+__m512 sin_float_avx512(const __m512 theta)
+{
+    const __m512 q = _mm512_roundscale_ps(_mm512_mul_ps(theta, _mm512_set1_ps(TWO_OVER_PI_F)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512 r = _mm512_fnmadd_ps(q, _mm512_set1_ps(PIO2_1F), theta);
+    r = _mm512_fnmadd_ps(q, _mm512_set1_ps(PIO2_2F), r);
+    r = _mm512_fnmadd_ps(q, _mm512_set1_ps(PIO2_3F), r);
+    const __m512 z = _mm512_mul_ps(r, r);
+
+    __m512 sin_poly = _mm512_fmadd_ps(z, _mm512_set1_ps(S3F), _mm512_set1_ps(S2F));
+    sin_poly = _mm512_fmadd_ps(z, sin_poly, _mm512_set1_ps(S1F));
+    const __m512 sin_r = _mm512_fmadd_ps(_mm512_mul_ps(r, z), sin_poly, r);
+
+    __m512 cos_poly = _mm512_fmadd_ps(z, _mm512_set1_ps(C3F), _mm512_set1_ps(C2F));
+    cos_poly = _mm512_fmadd_ps(z, cos_poly, _mm512_set1_ps(C1F));
+    const __m512 cos_r = _mm512_fmadd_ps(_mm512_mul_ps(z, z), cos_poly, _mm512_fnmadd_ps(_mm512_set1_ps(0.5f), z, _mm512_set1_ps(1.0f)));
+
+    // q mod 4 as an integer: q is exact for the phases we accept
+    const __m512i quadrant = _mm512_and_si512(_mm512_cvtps_epi32(q), _mm512_set1_epi32(3));
+    const __mmask16 use_cos = _mm512_test_epi32_mask(quadrant, _mm512_set1_epi32(1));
+    const __mmask16 negate = _mm512_test_epi32_mask(quadrant, _mm512_set1_epi32(2));
+    const __m512 result = _mm512_mask_blend_ps(use_cos, sin_r, cos_r);
+    return _mm512_mask_sub_ps(result, negate, _mm512_setzero_ps(), result);
+}
+
+void compute_elevations_float_avx512(const float* x, const float* y, const size_t n, const SinglePrecisionLines& lines, float* z)
+{
+    const size_t width = 16;
+    const size_t vectorized_n = n - n % width;
+    const size_t size = lines.size();
+    const __m512 max_phase = _mm512_set1_ps(ELEVATION_KERNEL_FLOAT_MAX_REDUCED_PHASE);
+    for (size_t index = 0; index < vectorized_n; index += width)
+    {
+        const __m512 x_i = _mm512_loadu_ps(x + index);
+        const __m512 y_i = _mm512_loadu_ps(y + index);
+        __m512 z_i = _mm512_setzero_ps();
+        for (size_t line = 0; line < size; ++line)
+        {
+            const __m512 theta = _mm512_fmadd_ps(x_i, _mm512_set1_ps(lines.k_cos_psi[line]),
+                                                 _mm512_fmadd_ps(y_i, _mm512_set1_ps(lines.k_sin_psi[line]), _mm512_set1_ps(lines.phase_t[line])));
+            __m512 sin_theta = sin_float_avx512(theta);
+            if (_mm512_cmp_ps_mask(_mm512_abs_ps(theta), max_phase, _CMP_GT_OQ))
+            {
+                alignas(64) float lanes[16];
+                _mm512_store_ps(lanes, theta);
+                for (size_t lane = 0; lane < width; ++lane)
+                {
+                    lanes[lane] = std::sin(lanes[lane]);
+                }
+                sin_theta = _mm512_load_ps(lanes);
+            }
+            z_i = _mm512_fnmadd_ps(_mm512_set1_ps(lines.a[line]), sin_theta, z_i);
+        }
+        _mm512_storeu_ps(z + index, z_i);
+    }
+    compute_elevations_float_scalar(x + vectorized_n, y + vectorized_n, n - vectorized_n, lines, z + vectorized_n);
+}
+#endif
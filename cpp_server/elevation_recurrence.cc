@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <cmath>
+#include "elevation_recurrence.hh"
+
+const size_t ElevationRecurrence::max_phasors;
+
+ElevationRecurrence::ElevationRecurrence(const WaveSpectrum& wave_spectrum,
+                                         const std::vector<double>& x,
+                                         const std::vector<double>& y,
+                                         const double t_start,
+                                         const double dt,
+                                         const size_t resynchronisation_period):
+    wave_spectrum_(wave_spectrum),
+    x_(x),
+    y_(y),
+    t_start_(t_start),
+    dt_(dt),
+    resynchronisation_period_(std::max(resynchronisation_period, size_t(1))),
+    step_(0),
+    cos_omega_dt_(wave_spectrum.size()),
+    sin_omega_dt_(wave_spectrum.size()),
+    cos_theta_(wave_spectrum.size() * x.size()),
+    sin_theta_(wave_spectrum.size() * x.size())
+{
+    for (size_t line = 0; line < wave_spectrum.size(); ++line)
+    {
+        cos_omega_dt_[line] = cos(wave_spectrum.omega()[line] * dt);
+        sin_omega_dt_[line] = sin(wave_spectrum.omega()[line] * dt);
+    }
+}
+
+bool ElevationRecurrence::fits(const WaveSpectrum& wave_spectrum, const size_t number_of_points)
+{
+    return wave_spectrum.size() == 0 || number_of_points <= max_phasors / wave_spectrum.size();
+}
+
+void ElevationRecurrence::synchronise()
+{
+    const double t = t_start_ + step_ * dt_;
+    const size_t number_of_points = x_.size();
+    for (size_t line = 0; line < wave_spectrum_.size(); ++line)
+    {
+        const double k_cos_psi = wave_spectrum_.k_cos_psi()[line];
+        const double k_sin_psi = wave_spectrum_.k_sin_psi()[line];
+        const double omega_t = wave_spectrum_.omega()[line] * t;
+        const double phase = wave_spectrum_.phase()[line];
+        double* cos_theta = cos_theta_.data() + line * number_of_points;
+        double* sin_theta = sin_theta_.data() + line * number_of_points;
+        for (size_t point = 0; point < number_of_points; ++point)
+        {
+            const double theta = x_[point] * k_cos_psi + y_[point] * k_sin_psi - omega_t + phase;
+            cos_theta[point] = cos(theta);
+            sin_theta[point] = sin(theta);
+        }
+    }
+}
+
+void ElevationRecurrence::next(double* z)
+{
+    if (step_ % resynchronisation_period_ == 0)
+    {
+        synchronise();
+    }
+    const size_t number_of_points = x_.size();
+    std::fill(z, z + number_of_points, 0.0);
+    for (size_t line = 0; line < wave_spectrum_.size(); ++line)
+    {
+        const double a = wave_spectrum_.a()[line];
+        const double cos_omega_dt = cos_omega_dt_[line];
+        const double sin_omega_dt = sin_omega_dt_[line];
+        double* cos_theta = cos_theta_.data() + line * number_of_points;
+        double* sin_theta = sin_theta_.data() + line * number_of_points;
+        for (size_t point = 0; point < number_of_points; ++point)
+        {
+            const double c = cos_theta[point];
+            const double s = sin_theta[point];
+            z[point] -= a * s;
+            // exp(i.(theta - omega.dt)) = exp(i.theta).exp(-i.omega.dt)
+            cos_theta[point] = c * cos_omega_dt + s * sin_omega_dt;
+            sin_theta[point] = s * cos_omega_dt - c * sin_omega_dt;
+        }
+    }
+    ++step_;
+}
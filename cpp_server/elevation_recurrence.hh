@@ -0,0 +1,51 @@
+#ifndef ELEVATION_RECURRENCE_HH
+#define ELEVATION_RECURRENCE_HH
+
+#include <cstddef>
+#include <vector>
+#include "wave_spectrum.hh"
+
+// Elevations of a fixed set of points at t_start, t_start + dt, t_start + 2.dt...
+//
+// For a given point, the phase of each spectrum line only changes by -omega.dt
+// from one time step to the next: instead of evaluating a sine, the phasor
+// exp(i.theta) of each (line, point) couple is rotated by exp(-i.omega.dt),
+// which costs a complex multiplication. Rounding errors accumulate linearly
+// with the number of steps, so the phasors are recomputed exactly every
+// resynchronisation_period steps.
+class ElevationRecurrence
+{
+    public:
+        // Upper bound on the number of (line, point) phasors kept in memory (16 bytes each)
+        static const size_t max_phasors = size_t(1) << 23;
+
+        ElevationRecurrence(const WaveSpectrum& wave_spectrum,
+                            const std::vector<double>& x,
+                            const std::vector<double>& y,
+                            const double t_start,
+                            const double dt,
+                            const size_t resynchronisation_period);
+
+        // Can the recurrence be used for this many points without exceeding max_phasors?
+        static bool fits(const WaveSpectrum& wave_spectrum, const size_t number_of_points);
+
+        // Writes the elevations at the current time step in z (of size x.size()), then moves to the next time step
+        void next(double* z);
+
+    private:
+        void synchronise();
+
+        const WaveSpectrum& wave_spectrum_;
+        const std::vector<double> x_;
+        const std::vector<double> y_;
+        const double t_start_;
+        const double dt_;
+        const size_t resynchronisation_period_;
+        size_t step_;
+        std::vector<double> cos_omega_dt_;
+        std::vector<double> sin_omega_dt_;
+        std::vector<double> cos_theta_;     //!< cos(theta) for each line, then each point
+        std::vector<double> sin_theta_;     //!< sin(theta) for each line, then each point
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <vector>
+#include "elevation_kernel.hh"
+#include "elevation_times.hh"
+#include "parallel_elevation.hh"
+
+void compute_elevations_at_times(const double* x, const double* y, const size_t n,
+                                 const double* t, const size_t number_of_times,
+                                 const WaveSpectrum& wave_spectrum, double* z, WorkerPool& pool)
+{
+    if (n == 0 || number_of_times == 0)
+    {
+        return;
+    }
+    if (number_of_times < ELEVATION_TIMES_MIN_TABULATED)
+    {
+        for (size_t j = 0; j < number_of_times; ++j)
+        {
+            compute_elevations(x, y, n, t[j], wave_spectrum, z + j * n, pool);
+        }
+        return;
+    }
+    const size_t lines = wave_spectrum.size();
+    const double* a = wave_spectrum.a();
+    const double* k_cos_psi = wave_spectrum.k_cos_psi();
+    const double* k_sin_psi = wave_spectrum.k_sin_psi();
+    const double* omega = wave_spectrum.omega();
+    const double* phase = wave_spectrum.phase();
+
+    // Time tables are time-major (contiguous along the lines of one time): cos(-omega.t) and sin(-omega.t)
+    // for the span_times times starting at first_time
+    const size_t span = std::max(ELEVATION_TIMES_MAX_TABLE_VALUES / std::max(lines, size_t(1))
+                                 / ELEVATION_TIMES_TIME_BLOCK * ELEVATION_TIMES_TIME_BLOCK, size_t(ELEVATION_TIMES_TIME_BLOCK));
+    const size_t table_times = std::min(number_of_times, span);
+    std::vector<double> cos_t(table_times * lines), sin_t(table_times * lines), minus_omega_t(lines);
+    size_t first_time = 0;
+    size_t span_times = 0;
+
+    const auto points = [&](const size_t begin, const size_t end)
+    {
+        // Point tables of the current block, line-major and including the factor -a
+        const size_t stride = std::min(end - begin, size_t(ELEVATION_TIMES_POINT_BLOCK));
+        std::vector<double> sin_x(lines * stride), cos_x(lines * stride);
+        double theta[ELEVATION_TIMES_POINT_BLOCK];
+        for (size_t i0 = begin; i0 < end; i0 += ELEVATION_TIMES_POINT_BLOCK)
+        {
+            const size_t columns = std::min(end - i0, size_t(ELEVATION_TIMES_POINT_BLOCK));
+            for (size_t line = 0; line < lines; ++line)
+            {
+                double* sx = &sin_x[line * stride];
+                double* cx = &cos_x[line * stride];
+                for (size_t i = 0; i < columns; ++i)
+                {
+                    theta[i] = x[i0 + i] * k_cos_psi[line] + y[i0 + i] * k_sin_psi[line] + phase[line];
+                }
+                compute_sin_cos(theta, columns, sx, cx);
+                for (size_t i = 0; i < columns; ++i)
+                {
+                    sx[i] *= -a[line];
+                    cx[i] *= -a[line];
+                }
+            }
+            for (size_t j0 = 0; j0 < span_times; j0 += ELEVATION_TIMES_TIME_BLOCK)
+            {
+                const size_t block_times = std::min(span_times - j0, size_t(ELEVATION_TIMES_TIME_BLOCK));
+                double block[ELEVATION_TIMES_TIME_BLOCK][ELEVATION_TIMES_POINT_BLOCK] = {};
+                for (size_t line = 0; line < lines; ++line)
+                {
+                    const double* sx = &sin_x[line * stride];
+                    const double* cx = &cos_x[line * stride];
+                    double c[ELEVATION_TIMES_TIME_BLOCK] = {};
+                    double s[ELEVATION_TIMES_TIME_BLOCK] = {};
+                    for (size_t r = 0; r < block_times; ++r)
+                    {
+                        c[r] = cos_t[(j0 + r) * lines + line];
+                        s[r] = sin_t[(j0 + r) * lines + line];
+                    }
+                    // Missing times of the last group have c = s = 0 and are not copied back
+                    for (size_t r = 0; r < ELEVATION_TIMES_TIME_BLOCK; ++r)
+                    {
+                        for (size_t i = 0; i < columns; ++i)
+                        {
+                            block[r][i] += sx[i] * c[r] + cx[i] * s[r];
+                        }
+                    }
+                }
+                for (size_t r = 0; r < block_times; ++r)
+                {
+                    std::copy(block[r], block[r] + columns, z + (first_time + j0 + r) * n + i0);
+                }
+            }
+        }
+    };
+    for (; first_time < number_of_times; first_time += span_times)
+    {
+        span_times = std::min(number_of_times - first_time, table_times);
+        for (size_t j = 0; j < span_times; ++j)
+        {
+            for (size_t line = 0; line < lines; ++line)
+            {
+                minus_omega_t[line] = -omega[line] * t[first_time + j];
+            }
+            compute_sin_cos(minus_omega_t.data(), lines, &sin_t[j * lines], &cos_t[j * lines]);
+        }
+        // Each point costs about as much as computing span_times/8 elevations point by point
+        const size_t work = std::max(lines, size_t(1)) * span_times;
+        if (pool.size() == 1 || n * work < 8 * PARALLEL_ELEVATION_THRESHOLD)
+        {
+            points(0, n);
+        }
+        else
+        {
+            const size_t blocks = std::max(8 * PARALLEL_ELEVATION_CHUNK / (work * ELEVATION_TIMES_POINT_BLOCK), size_t(1));
+            pool.parallel_for(n, blocks * ELEVATION_TIMES_POINT_BLOCK, points);
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef ELEVATION_TIMES_HH
+#define ELEVATION_TIMES_HH
+
+#include <cstddef>
+#include "wave_spectrum.hh"
+#include "worker_pool.hh"
+
+// Largest number of elevations of a multi-time request (number of points x number of times)
+#define ELEVATION_TIMES_MAX_VALUES (size_t(1) << 26)
+// The points are processed by blocks, whose tables stay in cache while all the times are
+// swept, and the times by groups, so that each value read from these tables is used several times
+#define ELEVATION_TIMES_POINT_BLOCK 128
+#define ELEVATION_TIMES_TIME_BLOCK 4
+// Largest number of values of each time table (cos and sin of omega.t for each time and line):
+// longer requests are computed by spans of times
+#define ELEVATION_TIMES_MAX_TABLE_VALUES (size_t(1) << 20)
+// Below this many times, tabulating does not pay off: each time is computed by compute_elevations
+#define ELEVATION_TIMES_MIN_TABULATED 4
+
+// Elevations of the n points (x, y) at each of the number_of_times instants t (in any
+// order, not necessarily evenly spaced), stored time by time: z[j.n + i] is the elevation
+// of point i at t[j].
+//
+// The spatial part of the phase does not depend on the time:
+//     sin(k.cos(psi).x[i] + k.sin(psi).y[i] + phase - omega.t[j])
+//         = sin(X[i]).cos(omega.t[j]) - cos(X[i]).sin(omega.t[j])
+// so sines and cosines are only evaluated (by compute_sin_cos) once per (point, line) and
+// once per (time, line), and the elevations are an accumulation of outer products of these
+// tables, i.e. 4 flops per (point, time, line) instead of a sine. The time tables are built
+// for a span of times at once, so that they take at most 16 MB whatever the request. As the two parts of the
+// phase are not rounded together, the results differ from compute_elevations by about the
+// rounding error of the phases (4e-12 m within 500 m and 20000 s on the 128 line spectrum).
+void compute_elevations_at_times(const double* x, const double* y, const size_t n,
+                                 const double* t, const size_t number_of_times,
+                                 const WaveSpectrum& wave_spectrum, double* z, WorkerPool& pool);
+
+#endif
@@ -0,0 +1,74 @@
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include "fft.hh"
+
+bool is_power_of_two(const size_t n)
+{
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+Fft::Fft(const size_t n, const bool inverse):
+    n_(n), bit_reversal_(n), twiddles_()
+{
+    if (not(is_power_of_two(n)))
+    {
+        throw std::invalid_argument("the size of the FFT should be a power of two");
+    }
+    size_t bits = 0;
+    while ((size_t(1) << bits) < n)
+    {
+        ++bits;
+    }
+    for (size_t index = 0; index < n; ++index)
+    {
+        size_t reversed = 0;
+        for (size_t bit = 0; bit < bits; ++bit)
+        {
+            reversed |= ((index >> bit) & 1) << (bits - 1 - bit);
+        }
+        bit_reversal_[index] = reversed;
+    }
+    // Each twiddle factor is computed directly (not by recurrence) to keep them accurate to 1 ULP
+    const double sign = inverse ? 1.0 : -1.0;
+    const double pi = 4.0 * std::atan(1.0);
+    twiddles_.reserve(n);
+    for (size_t length = 2; length <= n; length <<= 1)
+    {
+        for (size_t m = 0; m < length / 2; ++m)
+        {
+            const double angle = sign * 2 * pi * static_cast<double>(m) / static_cast<double>(length);
+            twiddles_.push_back(std::complex<double>(std::cos(angle), std::sin(angle)));
+        }
+    }
+}
+
+void Fft::transform(std::complex<double>* data) const
+{
+    for (size_t index = 0; index < n_; ++index)
+    {
+        if (index < bit_reversal_[index])
+        {
+            std::swap(data[index], data[bit_reversal_[index]]);
+        }
+    }
+    const std::complex<double>* stage_twiddles = twiddles_.data();
+    for (size_t length = 2; length <= n_; length <<= 1)
+    {
+        const size_t half = length / 2;
+        for (size_t start = 0; start < n_; start += length)
+        {
+            for (size_t m = 0; m < half; ++m)
+            {
+                // Product written out: std::complex's operator* goes through __muldc3 for its NaN checks
+                const std::complex<double> w = stage_twiddles[m];
+                const std::complex<double> b = data[start + m + half];
+                const std::complex<double> odd(b.real() * w.real() - b.imag() * w.imag(), b.real() * w.imag() + b.imag() * w.real());
+                const std::complex<double> even = data[start + m];
+                data[start + m] = even + odd;
+                data[start + m + half] = even - odd;
+            }
+        }
+        stage_twiddles += half;
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef FFT_HH
+#define FFT_HH
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+bool is_power_of_two(const size_t n);
+
+// In-place radix-2 discrete Fourier transform of n values (n a power of two):
+//     data[p] <- sum over i of data[i].exp(sign.2i.pi.p.i/n)
+// with sign = +1 if inverse (no 1/n normalisation), -1 otherwise.
+class Fft
+{
+    public:
+        Fft(const size_t n, const bool inverse);
+
+        size_t size() const {return n_;}
+        void transform(std::complex<double>* data) const;
+
+    private:
+        size_t n_;
+        std::vector<size_t> bit_reversal_;
+        std::vector<std::complex<double> > twiddles_; //!< exp(sign.2i.pi.m/length) for m in [0, length/2), for each stage (length = 2, 4, ... n)
+};
+
+#endif
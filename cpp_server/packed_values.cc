@@ -0,0 +1,98 @@
+#include <cstdint>
+#include <cstring>
+#include "packed_values.hh"
+
+using wave::PackedEncoding;
+
+bool is_little_endian();
+bool is_little_endian()
+{
+    const uint16_t one = 1;
+    unsigned char first_byte = 0;
+    std::memcpy(&first_byte, &one, 1);
+    return first_byte == 1;
+}
+
+template <typename T> T swap_bytes(const T value)
+{
+    T swapped;
+    const unsigned char* from = reinterpret_cast<const unsigned char*>(&value);
+    unsigned char* to = reinterpret_cast<unsigned char*>(&swapped);
+    for (size_t index = 0; index < sizeof(T); ++index)
+    {
+        to[index] = from[sizeof(T) - 1 - index];
+    }
+    return swapped;
+}
+
+template <typename T> void unpack(const char* bytes, const size_t n, double* values)
+{
+    const bool swap = not(is_little_endian());
+    for (size_t index = 0; index < n; ++index)
+    {
+        T value;
+        std::memcpy(&value, bytes + index * sizeof(T), sizeof(T));
+        values[index] = static_cast<double>(swap ? swap_bytes(value) : value);
+    }
+}
+
+template <typename T> void pack(const double* values, const size_t n, char* bytes)
+{
+    const bool swap = not(is_little_endian());
+    for (size_t index = 0; index < n; ++index)
+    {
+        const T value = static_cast<T>(values[index]);
+        const T encoded = swap ? swap_bytes(value) : value;
+        std::memcpy(bytes + index * sizeof(T), &encoded, sizeof(T));
+    }
+}
+
+size_t packed_value_size(const PackedEncoding encoding)
+{
+    return encoding == wave::FLOAT32 ? sizeof(float) : sizeof(double);
+}
+
+size_t number_of_packed_values(const std::string& bytes, const PackedEncoding encoding)
+{
+    return bytes.size() / packed_value_size(encoding);
+}
+
+const double* unpack_values(const std::string& bytes, const size_t n, const PackedEncoding encoding, std::vector<double>& buffer)
+{
+    const char* data = bytes.data();
+    if (encoding == wave::FLOAT64 && is_little_endian() && reinterpret_cast<uintptr_t>(data) % alignof(double) == 0)
+    {
+        return reinterpret_cast<const double*>(data);
+    }
+    buffer.resize(n);
+    if (encoding == wave::FLOAT32)
+    {
+        unpack<float>(data, n, buffer.data());
+    }
+    else
+    {
+        unpack<double>(data, n, buffer.data());
+    }
+    return buffer.data();
+}
+
+void pack_values(const double* values, const size_t n, const PackedEncoding encoding, std::string* bytes)
+{
+    bytes->resize(n * packed_value_size(encoding));
+    if (n == 0)
+    {
+        return;
+    }
+    if (encoding == wave::FLOAT32)
+    {
+        pack<float>(values, n, &(*bytes)[0]);
+    }
+    else if (is_little_endian())
+    {
+        std::memcpy(&(*bytes)[0], values, n * sizeof(double));
+    }
+    else
+    {
+        pack<double>(values, n, &(*bytes)[0]);
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef PACKED_VALUES_HH
+#define PACKED_VALUES_HH
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "wave.pb.h"
+
+// Conversions between the "bytes" fields of the packed messages (raw little-endian
+// IEEE 754 arrays) and arrays of doubles.
+
+size_t packed_value_size(const wave::PackedEncoding encoding);
+
+// Number of complete values in bytes
+size_t number_of_packed_values(const std::string& bytes, const wave::PackedEncoding encoding);
+
+// First n values of bytes. When no conversion is needed (little-endian host, FLOAT64,
+// 8-byte aligned data), returns a pointer into bytes itself; otherwise decodes into buffer.
+const double* unpack_values(const std::string& bytes, const size_t n, const wave::PackedEncoding encoding, std::vector<double>& buffer);
+
+// Replaces the content of bytes with the n values, encoded as requested
+void pack_values(const double* values, const size_t n, const wave::PackedEncoding encoding, std::string* bytes);
+
+#endif
@@ -0,0 +1,35 @@
+#include <algorithm>
+#include "elevation_kernel.hh"
+#include "parallel_elevation.hh"
+
+void compute_elevations(const double* x, const double* y, const size_t n, const double t, const WaveSpectrum& wave_spectrum, double* z, WorkerPool& pool)
+{
+    const size_t lines = std::max(wave_spectrum.size(), size_t(1));
+    if (pool.size() == 1 || n * lines < PARALLEL_ELEVATION_THRESHOLD)
+    {
+        compute_elevations(x, y, n, t, wave_spectrum, z);
+        return;
+    }
+    // Chunks are a multiple of the widest SIMD register (8 doubles) so that only the last one has a scalar tail
+    const size_t chunk_size = std::max(PARALLEL_ELEVATION_CHUNK / lines / 8, size_t(1)) * 8;
+    pool.parallel_for(n, chunk_size, [&](const size_t begin, const size_t end)
+                                     {
+                                         compute_elevations(x + begin, y + begin, end - begin, t, wave_spectrum, z + begin);
+                                     });
+}
+
+void compute_elevations_float(const float* x, const float* y, const size_t n, const SinglePrecisionLines& lines, float* z, WorkerPool& pool)
+{
+    const size_t size = std::max(lines.size(), size_t(1));
+    if (pool.size() == 1 || n * size < PARALLEL_ELEVATION_THRESHOLD)
+    {
+        compute_elevations_float(x, y, n, lines, z);
+        return;
+    }
+    // 16 floats per AVX-512 register
+    const size_t chunk_size = std::max(PARALLEL_ELEVATION_CHUNK / size / 16, size_t(1)) * 16;
+    pool.parallel_for(n, chunk_size, [&](const size_t begin, const size_t end)
+                                     {
+                                         compute_elevations_float(x + begin, y + begin, end - begin, lines, z + begin);
+                                     });
+}
@@ -0,0 +1,20 @@
+#ifndef PARALLEL_ELEVATION_HH
+#define PARALLEL_ELEVATION_HH
+
+#include <cstddef>
+#include "elevation_kernel.hh"
+#include "wave_spectrum.hh"
+#include "worker_pool.hh"
+
+// Below this many (point, spectrum line) couples, elevations are computed on the calling thread
+#define PARALLEL_ELEVATION_THRESHOLD (size_t(1) << 17)
+// Approximate number of (point, spectrum line) couples processed by each chunk
+#define PARALLEL_ELEVATION_CHUNK (size_t(1) << 16)
+
+// Same as compute_elevations (elevation_kernel.hh) but splits large point sets
+// across the threads of the pool. Small requests stay on the calling thread.
+void compute_elevations(const double* x, const double* y, const size_t n, const double t, const WaveSpectrum& wave_spectrum, double* z, WorkerPool& pool);
+// Same for compute_elevations_float
+void compute_elevations_float(const float* x, const float* y, const size_t n, const SinglePrecisionLines& lines, float* z, WorkerPool& pool);
+
+#endif
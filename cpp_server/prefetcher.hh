@@ -0,0 +1,130 @@
+#ifndef PREFETCHER_HH
+#define PREFETCHER_HH
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Produces the messages of a stream on its own thread, one message ahead of
+// the consumer: the next message is computed while the current one is sent.
+//
+// produce(message) fills message and returns false once there is nothing left
+// to produce. Only two messages exist: produce writes one while the consumer
+// reads the other, and waits for the consumer to be done with it before
+// reusing it. Destroying the prefetcher stops the production once the message
+// being produced (if any) is done, so a stream can be abandoned at any time.
+// If produce throws, the production stops and next rethrows the exception once
+// the messages produced before have been consumed.
+template <typename Message> class Prefetcher
+{
+    public:
+        explicit Prefetcher(const std::function<bool(Message*)>& produce):
+            produce_(produce), messages_(), ready_(), produced_(0), consumed_(0), has_current_(false),
+            done_(false), error_(), stopping_(false), mutex_(), changed_(), thread_()
+        {
+            ready_[0] = false;
+            ready_[1] = false;
+            thread_ = std::thread(&Prefetcher::run, this);
+        }
+
+        Prefetcher(const Prefetcher&) = delete;
+        Prefetcher& operator=(const Prefetcher&) = delete;
+
+        ~Prefetcher()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            changed_.notify_all();
+            thread_.join();
+        }
+
+        // Next message, valid until the following call, or nullptr once all messages have been produced.
+        // Rethrows the exception of produce, if any, after the last message produced.
+        const Message* next()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (has_current_)
+            {
+                ready_[consumed_] = false;
+                consumed_ = 1 - consumed_;
+                has_current_ = false;
+                changed_.notify_all();
+            }
+            changed_.wait(lock, [this] {return ready_[consumed_] || done_;});
+            if (not(ready_[consumed_]))
+            {
+                if (error_)
+                {
+                    std::rethrow_exception(error_);
+                }
+                return nullptr;
+            }
+            has_current_ = true;
+            return &messages_[consumed_];
+        }
+
+    private:
+        void run()
+        {
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    changed_.wait(lock, [this] {return stopping_ || not(ready_[produced_]);});
+                    if (stopping_)
+                    {
+                        return;
+                    }
+                }
+                // The consumer never reads a message that is not ready: no lock while producing
+                bool produced = false;
+                std::exception_ptr error;
+                try
+                {
+                    produced = produce_(&messages_[produced_]);
+                }
+                catch (...)
+                {
+                    // Would terminate the process on this thread
+                    error = std::current_exception();
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (produced)
+                    {
+                        ready_[produced_] = true;
+                        produced_ = 1 - produced_;
+                    }
+                    else
+                    {
+                        done_ = true;
+                        error_ = error;
+                    }
+                }
+                changed_.notify_all();
+                if (not(produced))
+                {
+                    return;
+                }
+            }
+        }
+
+        const std::function<bool(Message*)> produce_;
+        Message messages_[2];
+        bool ready_[2];         //!< Produced and not consumed yet
+        unsigned int produced_; //!< Message produce_ writes next
+        unsigned int consumed_; //!< Message next returns
+        bool has_current_;      //!< messages_[consumed_] has been returned by next
+        bool done_;
+        std::exception_ptr error_;  //!< Thrown by produce_, ends the production
+        bool stopping_;
+        std::mutex mutex_;
+        std::condition_variable changed_;
+        std::thread thread_;
+};
+
+#endif
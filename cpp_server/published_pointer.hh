@@ -0,0 +1,99 @@
+#ifndef PUBLISHED_POINTER_HH
+#define PUBLISHED_POINTER_HH
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Shared pointer to an immutable object that can be replaced while other
+// threads are reading it, readers never taking a lock (read-copy-update).
+//
+// std::atomic_load on a std::shared_ptr would do, but libstdc++ implements it
+// with a pool of mutexes. Here the pointer lives in one of two slots: a reader
+// registers in the current slot, checks it is still the current one and copies
+// the pointer (an atomic increment of the reference count). It can then use the
+// object for as long as it wants: the object is destroyed with its last copy.
+// A writer fills the other slot once the readers possibly copying from it are
+// gone, makes it current, and then empties the old one the same way. The
+// readers only wait for a writer if they happened to register in a slot being
+// switched, and then retry at once. Writers are serialised by a mutex.
+template <typename T> class PublishedPointer
+{
+    public:
+        explicit PublishedPointer(const std::shared_ptr<T>& value = std::shared_ptr<T>()):
+            slots_(), readers_(), current_(0), writer_mutex_()
+        {
+            slots_[0].value = value;
+            slots_[0].version = 0;
+            slots_[1].version = 0;
+            readers_[0].store(0);
+            readers_[1].store(0);
+        }
+
+        PublishedPointer(const PublishedPointer&) = delete;
+        PublishedPointer& operator=(const PublishedPointer&) = delete;
+
+        std::shared_ptr<T> get() const
+        {
+            uint64_t version = 0;
+            return get(version);
+        }
+
+        // version is incremented by each publish, so that values derived from
+        // the object can be told apart from those of the next one
+        std::shared_ptr<T> get(uint64_t& version) const
+        {
+            for (;;)
+            {
+                const unsigned int index = current_.load();
+                readers_[index].fetch_add(1);
+                if (current_.load() == index)
+                {
+                    const std::shared_ptr<T> value = slots_[index].value;
+                    version = slots_[index].version;
+                    readers_[index].fetch_sub(1);
+                    return value;
+                }
+                readers_[index].fetch_sub(1);
+            }
+        }
+
+        // Returns the version of value
+        uint64_t publish(const std::shared_ptr<T>& value)
+        {
+            std::lock_guard<std::mutex> lock(writer_mutex_);
+            const unsigned int old_index = current_.load();
+            const unsigned int new_index = 1 - old_index;
+            wait_for_readers(new_index);
+            slots_[new_index].value = value;
+            slots_[new_index].version = slots_[old_index].version + 1;
+            current_.store(new_index);
+            wait_for_readers(old_index);
+            slots_[old_index].value.reset();
+            return slots_[new_index].version;
+        }
+
+    private:
+        struct Slot
+        {
+            std::shared_ptr<T> value;
+            uint64_t version;
+        };
+
+        void wait_for_readers(const unsigned int index) const
+        {
+            while (readers_[index].load() != 0)
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        Slot slots_[2];
+        mutable std::atomic<unsigned int> readers_[2];
+        std::atomic<unsigned int> current_;
+        std::mutex writer_mutex_;
+};
+
+#endif
@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include "server_metrics.hh"
+
+#define SUB_BUCKETS (uint64_t(1) << SERVER_METRICS_SUB_BUCKET_BITS)
+
+size_t metric_bucket_index(const uint64_t value);
+size_t metric_bucket_index(const uint64_t value)
+{
+    if (value < SUB_BUCKETS)
+    {
+        return static_cast<size_t>(value);
+    }
+    // Position of the most significant bit, at least SERVER_METRICS_SUB_BUCKET_BITS here
+    const unsigned int magnitude = 63 - static_cast<unsigned int>(__builtin_clzll(value));
+    const unsigned int shift = magnitude - SERVER_METRICS_SUB_BUCKET_BITS;
+    return static_cast<size_t>((shift + 1) * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS));
+}
+
+// Largest value counted in the bucket
+uint64_t metric_highest_equivalent_value(const size_t index);
+uint64_t metric_highest_equivalent_value(const size_t index)
+{
+    if (index < SUB_BUCKETS)
+    {
+        return index;
+    }
+    const uint64_t shift = index / SUB_BUCKETS - 1;
+    const uint64_t lowest = (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    return lowest + ((uint64_t(1) << shift) - 1);
+}
+
+MetricHistogram::MetricHistogram():
+    count_(0), sum_(0), max_(0)
+{
+    for (std::atomic<uint64_t>& count : counts_)
+    {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+void MetricHistogram::record(const uint64_t value)
+{
+    counts_[metric_bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (value > max && not(max_.compare_exchange_weak(max, value, std::memory_order_relaxed)))
+    {
+    }
+}
+
+double MetricHistogram::mean() const
+{
+    const uint64_t count = count_.load(std::memory_order_relaxed);
+    return count > 0 ? static_cast<double>(sum_.load(std::memory_order_relaxed)) / static_cast<double>(count) : 0;
+}
+
+uint64_t MetricHistogram::percentile(const double percentile) const
+{
+    // Counted from the buckets rather than count_, which may already include a record not yet in its bucket
+    uint64_t count = 0;
+    for (const std::atomic<uint64_t>& bucket_count : counts_)
+    {
+        count += bucket_count.load(std::memory_order_relaxed);
+    }
+    if (count == 0)
+    {
+        return 0;
+    }
+    const double fraction = std::min(std::max(percentile, 0.), 100.) / 100.;
+    const uint64_t rank = std::max(uint64_t(1), static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(count))));
+    uint64_t cumulated = 0;
+    for (size_t index = 0; index < SERVER_METRICS_BUCKETS; ++index)
+    {
+        cumulated += counts_[index].load(std::memory_order_relaxed);
+        if (cumulated >= rank)
+        {
+            return std::min(metric_highest_equivalent_value(index), max());
+        }
+    }
+    return max();
+}
+
+const char* to_string(const Rpc rpc)
+{
+    switch (rpc)
+    {
+        case Rpc::GET_ELEVATION:
+            return "GetElevation";
+        case Rpc::GET_ELEVATION_INPUT_REPEATED:
+            return "GetElevationInputRepeated";
+        case Rpc::GET_ELEVATION_OUTPUT_REPEATED:
+            return "GetElevationOutputRepeated";
+        case Rpc::GET_ELEVATION_REPEATED:
+            return "GetElevationRepeated";
+        case Rpc::GET_ELEVATION_OUTPUT_REPEATED_Z:
+            return "GetElevationOutputRepeatedZ";
+        case Rpc::GET_ELEVATION_REPEATED_Z:
+            return "GetElevationRepeatedZ";
+        case Rpc::GET_ELEVATION_REPEATED_FLOAT:
+            return "GetElevationRepeatedFloat";
+        case Rpc::GET_ELEVATIONS:
+            return "GetElevations";
+        case Rpc::GET_ELEVATION_PACKED:
+            return "GetElevationPacked";
+        case Rpc::GET_ELEVATION_PACKED_Z:
+            return "GetElevationPackedZ";
+        case Rpc::ELEVATION_SESSION:
+            return "ElevationSession";
+        case Rpc::GET_ELEVATION_GRID:
+            return "GetElevationGrid";
+        case Rpc::GET_ELEVATION_SNAPSHOT:
+            return "GetElevationSnapshot";
+        case Rpc::GET_ELEVATION_TIMES:
+            return "GetElevationTimes";
+        case Rpc::GET_ELEVATION_SHARED:
+            return "GetElevationShared";
+        case Rpc::SET_WAVE_SPECTRUM:
+            return "SetWaveSpectrum";
+        case Rpc::GET_SERVER_STATS:
+            return "GetServerStats";
+        case Rpc::NUMBER_OF_RPCS:
+            break;
+    }
+    return "unknown";
+}
+
+bool is_stream(const Rpc rpc)
+{
+    return rpc == Rpc::GET_ELEVATIONS || rpc == Rpc::ELEVATION_SESSION;
+}
+
+RpcMetrics::RpcMetrics():
+    calls(0), errors(0), messages(0), compute_time(), reply_time(), points(), request_bytes(), response_bytes()
+{
+}
+
+ServerMetrics::ServerMetrics():
+    start_(std::chrono::steady_clock::now()), rpcs_(), in_flight_calls_(0), in_flight_bytes_(0), active_streams_(0)
+{
+}
+
+size_t ServerMetrics::record_request(const Rpc rpc, const google::protobuf::Message& request, const size_t number_of_points)
+{
+    const size_t size = request.ByteSizeLong();
+    RpcMetrics& metrics = rpcs_[static_cast<size_t>(rpc)];
+    metrics.points.record(number_of_points);
+    metrics.request_bytes.record(size);
+    return size;
+}
+
+double ServerMetrics::uptime() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+}
+
+ResponseRecorder::ResponseRecorder(ServerMetrics& metrics, const Rpc rpc, const google::protobuf::Message& request, const size_t number_of_points,
+                                   const google::protobuf::Message& response):
+    metrics_(metrics), rpc_(metrics.rpc(rpc)), response_(response), request_bytes_(metrics.record_request(rpc, request, number_of_points)),
+    start_(std::chrono::steady_clock::now())
+{
+    if (not(is_stream(rpc)))
+    {
+        rpc_.calls.fetch_add(1, std::memory_order_relaxed);
+    }
+    metrics_.in_flight_calls_.fetch_add(1, std::memory_order_relaxed);
+    metrics_.in_flight_bytes_.fetch_add(static_cast<int64_t>(request_bytes_), std::memory_order_relaxed);
+}
+
+ResponseRecorder::ResponseRecorder(ServerMetrics& metrics, const Rpc rpc, const google::protobuf::Message& response):
+    metrics_(metrics), rpc_(metrics.rpc(rpc)), response_(response), request_bytes_(0), start_(std::chrono::steady_clock::now())
+{
+    metrics_.in_flight_calls_.fetch_add(1, std::memory_order_relaxed);
+}
+
+ResponseRecorder::~ResponseRecorder()
+{
+    const std::chrono::nanoseconds compute_time = std::chrono::steady_clock::now() - start_;
+    metrics_.in_flight_calls_.fetch_sub(1, std::memory_order_relaxed);
+    metrics_.in_flight_bytes_.fetch_sub(static_cast<int64_t>(request_bytes_), std::memory_order_relaxed);
+    if (std::uncaught_exception())
+    {
+        rpc_.errors.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    rpc_.messages.fetch_add(1, std::memory_order_relaxed);
+    rpc_.compute_time.record(static_cast<uint64_t>(compute_time.count()));
+    rpc_.response_bytes.record(response_.ByteSizeLong());
+}
+
+StreamRecorder::StreamRecorder(ServerMetrics& metrics, const Rpc rpc):
+    metrics_(metrics)
+{
+    metrics_.rpc(rpc).calls.fetch_add(1, std::memory_order_relaxed);
+    metrics_.active_streams_.fetch_add(1, std::memory_order_relaxed);
+}
+
+StreamRecorder::~StreamRecorder()
+{
+    metrics_.active_streams_.fetch_sub(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,151 @@
+#ifndef SERVER_METRICS_HH
+#define SERVER_METRICS_HH
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <google/protobuf/message.h>
+
+// Each power of two is split into 2^SERVER_METRICS_SUB_BUCKET_BITS buckets:
+// the recorded values are known to within 1/8 (12.5 %)
+#define SERVER_METRICS_SUB_BUCKET_BITS 3
+#define SERVER_METRICS_BUCKETS ((64 - SERVER_METRICS_SUB_BUCKET_BITS) << SERVER_METRICS_SUB_BUCKET_BITS)
+
+// Distribution of a non-negative quantity (a duration in ns, a size...) in
+// log-linear buckets, HdrHistogram style. Lock free: all threads record in the
+// same histogram, each record being a few relaxed atomic operations, and it can
+// be read at any time (each counter is exact, but they may be read a few records
+// apart from each other).
+class MetricHistogram
+{
+    public:
+        MetricHistogram();
+        MetricHistogram(const MetricHistogram&) = delete;
+        MetricHistogram& operator=(const MetricHistogram&) = delete;
+
+        void record(const uint64_t value);
+
+        uint64_t count() const {return count_.load(std::memory_order_relaxed);}
+        double mean() const;
+        uint64_t max() const {return max_.load(std::memory_order_relaxed);}
+        // Smallest value greater than or equal to percentile % of the recorded ones
+        // (to within the bucket width), 0 if none was recorded
+        uint64_t percentile(const double percentile) const;
+
+    private:
+        std::atomic<uint64_t> counts_[SERVER_METRICS_BUCKETS];
+        std::atomic<uint64_t> count_;
+        std::atomic<uint64_t> sum_;
+        std::atomic<uint64_t> max_;
+};
+
+enum class Rpc
+{
+    GET_ELEVATION,
+    GET_ELEVATION_INPUT_REPEATED,
+    GET_ELEVATION_OUTPUT_REPEATED,
+    GET_ELEVATION_REPEATED,
+    GET_ELEVATION_OUTPUT_REPEATED_Z,
+    GET_ELEVATION_REPEATED_Z,
+    GET_ELEVATION_REPEATED_FLOAT,
+    GET_ELEVATIONS,
+    GET_ELEVATION_PACKED,
+    GET_ELEVATION_PACKED_Z,
+    ELEVATION_SESSION,
+    GET_ELEVATION_GRID,
+    GET_ELEVATION_SNAPSHOT,
+    GET_ELEVATION_TIMES,
+    GET_ELEVATION_SHARED,
+    SET_WAVE_SPECTRUM,
+    GET_SERVER_STATS,
+    NUMBER_OF_RPCS
+};
+
+// Name of the method in the service
+const char* to_string(const Rpc rpc);
+bool is_stream(const Rpc rpc);
+
+// What the server records about each RPC
+struct RpcMetrics
+{
+    RpcMetrics();
+    std::atomic<uint64_t> calls;        //!< Started calls
+    std::atomic<uint64_t> errors;       //!< Responses that could not be computed (invalid argument)
+    std::atomic<uint64_t> messages;     //!< Responses computed: one per unary call, several per stream
+    MetricHistogram compute_time;       //!< Per response, in ns, from the deserialized request to the filled response
+    MetricHistogram reply_time;         //!< Asynchronous server only, per unary call, in ns: serialization and hand-off of the response to the transport
+    MetricHistogram points;             //!< Per request message
+    MetricHistogram request_bytes;      //!< Serialized size of each request message
+    MetricHistogram response_bytes;     //!< Serialized size of each response message
+};
+
+// Counters and distributions of the requests served, shared by all the RPCs.
+// Recording costs two steady clock reads and a few relaxed atomic operations
+// per message, plus the computation of the serialized sizes of the request and
+// response, which is proportional to their number of fields for the messages
+// made of repeated sub-messages (repeated Point, ElevationPoint) and constant otherwise.
+class ServerMetrics
+{
+    public:
+        ServerMetrics();
+
+        RpcMetrics& rpc(const Rpc rpc) {return rpcs_[static_cast<size_t>(rpc)];}
+        const RpcMetrics& rpc(const Rpc rpc) const {return rpcs_[static_cast<size_t>(rpc)];}
+
+        // Size and points of a request message, returns its size
+        size_t record_request(const Rpc rpc, const google::protobuf::Message& request, const size_t number_of_points);
+
+        double uptime() const;  //!< In s
+        int64_t in_flight_calls() const {return in_flight_calls_;}  //!< Responses being computed
+        int64_t in_flight_bytes() const {return in_flight_bytes_;}  //!< Serialized size of the requests of these responses
+        int64_t active_streams() const {return active_streams_;}
+
+    private:
+        friend class ResponseRecorder;
+        friend class StreamRecorder;
+
+        const std::chrono::steady_clock::time_point start_;
+        RpcMetrics rpcs_[static_cast<size_t>(Rpc::NUMBER_OF_RPCS)];
+        std::atomic<int64_t> in_flight_calls_;
+        std::atomic<int64_t> in_flight_bytes_;
+        std::atomic<int64_t> active_streams_;
+};
+
+// Records the computation of a response, from construction to destruction: its
+// time, its size and whether it failed (destroyed by an exception), as well as
+// the call itself for the unary RPCs. The response should not change after.
+class ResponseRecorder
+{
+    public:
+        // Response to request (a unary call, or a message of an ElevationSession)
+        ResponseRecorder(ServerMetrics& metrics, const Rpc rpc, const google::protobuf::Message& request, const size_t number_of_points,
+                         const google::protobuf::Message& response);
+        // Message of a stream whose request was recorded when it started (GetElevations)
+        ResponseRecorder(ServerMetrics& metrics, const Rpc rpc, const google::protobuf::Message& response);
+        ResponseRecorder(const ResponseRecorder&) = delete;
+        ResponseRecorder& operator=(const ResponseRecorder&) = delete;
+        ~ResponseRecorder();
+
+    private:
+        ServerMetrics& metrics_;
+        RpcMetrics& rpc_;
+        const google::protobuf::Message& response_;
+        const size_t request_bytes_;
+        const std::chrono::steady_clock::time_point start_;
+};
+
+// Records a stream call, active as long as the recorder exists
+class StreamRecorder
+{
+    public:
+        StreamRecorder(ServerMetrics& metrics, const Rpc rpc);
+        StreamRecorder(const StreamRecorder&) = delete;
+        StreamRecorder& operator=(const StreamRecorder&) = delete;
+        ~StreamRecorder();
+
+    private:
+        ServerMetrics& metrics_;
+};
+
+#endif
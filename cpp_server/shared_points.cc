@@ -0,0 +1,159 @@
+#include <atomic>
+#include <cerrno>
+#include <csetjmp>
+#include <csignal>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "shared_points.hh"
+
+static_assert(sizeof(SharedPointsHeader) == SHARED_POINTS_HEADER_SIZE, "SharedPointsHeader should not be padded");
+
+// Only the segments of the clients: any other name would let a client write into another shared memory segment of the host
+void check_segment_name(const std::string& segment);
+void check_segment_name(const std::string& segment)
+{
+    const std::string prefix(SHARED_POINTS_NAME_PREFIX);
+    if (segment.compare(0, prefix.size(), prefix) != 0 || segment.size() == prefix.size()
+        || segment.find('/', prefix.size()) != std::string::npos)
+    {
+        throw std::invalid_argument("the shared memory segment name should start with " + prefix + " and contain no other /");
+    }
+}
+
+// Set while the calling thread copies from or to a segment: where SIGBUS jumps to
+static thread_local sigjmp_buf* segment_copy = nullptr;
+
+// Accessing the pages of a segment shrunk by its client (ftruncate) raises SIGBUS. During a
+// copy, this ends the copy instead; anywhere else, SIGBUS keeps its default action.
+void on_sigbus(int signal_number);
+void on_sigbus(int signal_number)
+{
+    if (segment_copy != nullptr)
+    {
+        siglongjmp(*segment_copy, 1);
+    }
+    // The faulting access is made again, and kills the process
+    std::signal(signal_number, SIG_DFL);
+}
+
+void install_sigbus_handler();
+void install_sigbus_handler()
+{
+    static std::once_flag installed;
+    std::call_once(installed, []
+    {
+        struct sigaction action;
+        std::memset(&action, 0, sizeof(action));
+        action.sa_handler = on_sigbus;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGBUS, &action, nullptr);
+    });
+}
+
+// Returns false if the segment was shrunk below the copied bytes
+bool guarded_copy(void* destination, const void* source, const size_t size);
+bool guarded_copy(void* destination, const void* source, const size_t size)
+{
+    sigjmp_buf jump;
+    // The signal mask is saved: SIGBUS is blocked in the handler, and unblocked by the jump
+    if (sigsetjmp(jump, 1) != 0)
+    {
+        segment_copy = nullptr;
+        return false;
+    }
+    segment_copy = &jump;
+    // Otherwise the compiler could drop the first store, or move the copy out of the guarded region
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    std::memcpy(destination, source, size);
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    segment_copy = nullptr;
+    return true;
+}
+
+SharedPoints::SharedPoints(const std::string& segment, const uint64_t token, const size_t number_of_points):
+    segment_(segment), mapping_(MAP_FAILED), mapping_size_(0), arrays_(nullptr), capacity_(0), x_(), y_(), z_(), size_(number_of_points)
+{
+    check_segment_name(segment);
+    install_sigbus_handler();
+    const int descriptor = shm_open(segment.c_str(), O_RDWR, 0);
+    if (descriptor < 0)
+    {
+        throw std::invalid_argument("Unable to open the shared memory segment " + segment + ": " + std::strerror(errno));
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(SharedPointsHeader))
+    {
+        close(descriptor);
+        throw std::invalid_argument(segment + " is not a shared point segment");
+    }
+    mapping_size_ = static_cast<size_t>(status.st_size);
+    mapping_ = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    // The mapping stays valid once the descriptor is closed
+    close(descriptor);
+    if (mapping_ == MAP_FAILED)
+    {
+        throw std::invalid_argument("Unable to map the shared memory segment " + segment + ": " + std::strerror(errno));
+    }
+    SharedPointsHeader header;
+    const bool has_header = guarded_copy(&header, mapping_, sizeof(header));
+    const size_t capacity = static_cast<size_t>(header.capacity);
+    std::string error;
+    if (not(has_header))
+    {
+        error = "the shared memory segment " + segment + " was shrunk";
+    }
+    else if (std::memcmp(header.magic, SHARED_POINTS_MAGIC, sizeof(header.magic)) != 0 || header.token != token)
+    {
+        error = segment + " is not the shared point segment of this client";
+    }
+    else if (capacity > (mapping_size_ - sizeof(header)) / (3 * sizeof(double)))
+    {
+        error = segment + " is smaller than its capacity";
+    }
+    else if (number_of_points > capacity)
+    {
+        error = "the shared memory segment " + segment + " holds at most " + std::to_string(capacity) + " points";
+    }
+    if (not(error.empty()))
+    {
+        munmap(mapping_, mapping_size_);
+        throw std::invalid_argument(error);
+    }
+    arrays_ = reinterpret_cast<double*>(static_cast<char*>(mapping_) + sizeof(header));
+    capacity_ = capacity;
+    try
+    {
+        x_.resize(number_of_points);
+        y_.resize(number_of_points);
+        z_.resize(number_of_points);
+    }
+    catch (...)
+    {
+        munmap(mapping_, mapping_size_);
+        throw;
+    }
+    if (not(guarded_copy(x_.data(), arrays_, number_of_points * sizeof(double)))
+        || not(guarded_copy(y_.data(), arrays_ + capacity_, number_of_points * sizeof(double))))
+    {
+        munmap(mapping_, mapping_size_);
+        throw std::invalid_argument("the shared memory segment " + segment + " was shrunk");
+    }
+}
+
+void SharedPoints::write_z()
+{
+    if (not(guarded_copy(arrays_ + 2 * capacity_, z_.data(), size_ * sizeof(double))))
+    {
+        throw std::invalid_argument("the shared memory segment " + segment_ + " was shrunk");
+    }
+}
+
+SharedPoints::~SharedPoints()
+{
+    munmap(mapping_, mapping_size_);
+}
@@ -0,0 +1,60 @@
+#ifndef SHARED_POINTS_HH
+#define SHARED_POINTS_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define SHARED_POINTS_MAGIC "WAVESHM1"
+#define SHARED_POINTS_HEADER_SIZE 64
+#define SHARED_POINTS_NAME_PREFIX "/wave_client."
+
+// Header of the shared memory segment of a GetElevationShared client (see ElevationRequestShared):
+// the arrays x, y and z of capacity doubles each follow it, aligned on 64 bytes.
+struct SharedPointsHeader
+{
+    char magic[8];
+    uint64_t token;
+    uint64_t capacity;
+    char reserved[SHARED_POINTS_HEADER_SIZE - 24];
+};
+
+// Points of a GetElevationShared request, mapped from the segment of the client for
+// the duration of the request. The client can still write into its segment, or shrink
+// it, while the server computes: x and y are copied once they are checked, so that
+// the elevations (and the cache entries) are those of the points that were checked,
+// and z is computed in the server's memory, then copied into the segment by write_z.
+// These copies are the only accesses to the segment, and a segment shrunk meanwhile
+// makes them throw instead of killing the server with SIGBUS.
+class SharedPoints
+{
+    public:
+        // Throws std::invalid_argument if the segment is not a client segment, cannot be opened
+        // or mapped, does not have this token or holds less than number_of_points points
+        SharedPoints(const std::string& segment, const uint64_t token, const size_t number_of_points);
+        SharedPoints(const SharedPoints&) = delete;
+        SharedPoints& operator=(const SharedPoints&) = delete;
+        ~SharedPoints();
+
+        const double* x() const {return x_.data();}
+        const double* y() const {return y_.data();}
+        double* z() {return z_.data();}
+        size_t size() const {return size_;}
+
+        // Copies z into the segment. Throws std::invalid_argument if the segment was shrunk.
+        void write_z();
+
+    private:
+        std::string segment_;
+        void* mapping_;
+        size_t mapping_size_;
+        double* arrays_;        //!< x, y and z of the segment, capacity_ doubles each
+        size_t capacity_;
+        std::vector<double> x_;
+        std::vector<double> y_;
+        std::vector<double> z_;
+        size_t size_;
+};
+
+#endif
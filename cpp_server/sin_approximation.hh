@@ -0,0 +1,49 @@
+#ifndef SIN_APPROXIMATION_HH
+#define SIN_APPROXIMATION_HH
+
+// Constants of the sine used by the vectorized elevation kernels.
+//
+// theta is reduced to r in [-pi/4, pi/4] with q = round(theta.2/pi) and a
+// three-part Cody-Waite splitting of pi/2 (each product q.PIO2_x is exact for
+// |q| < 2^20), then sin(theta) is sin(r), cos(r), -sin(r) or -cos(r) depending
+// on q mod 4. The polynomials are the minimax approximations of fdlibm's
+// __kernel_sin and __kernel_cos on [-pi/4, pi/4].
+namespace sin_approximation
+{
+    static const double TWO_OVER_PI = 6.36619772367581382433e-01;
+    static const double PIO2_1 = 1.57079632673412561417e+00;  //!< First 33 bits of pi/2
+    static const double PIO2_2 = 6.07710050630396597660e-11;  //!< Second 33 bits of pi/2
+    static const double PIO2_3 = 2.02226624879595063154e-21;  //!< pi/2 - (PIO2_1 + PIO2_2)
+
+    static const double S1 = -1.66666666666666324348e-01;
+    static const double S2 = 8.33333333332248946124e-03;
+    static const double S3 = -1.98412698298579493134e-04;
+    static const double S4 = 2.75573137070700676789e-06;
+    static const double S5 = -2.50507602534068634195e-08;
+    static const double S6 = 1.58969099521155010221e-10;
+
+    static const double C1 = 4.16666666666666019037e-02;
+    static const double C2 = -1.38888888888741095749e-03;
+    static const double C3 = 2.48015872894767294178e-05;
+    static const double C4 = -2.75573143513906633035e-07;
+    static const double C5 = 2.08757232129817482790e-09;
+    static const double C6 = -1.13596475577881948265e-11;
+
+    // Same reduction in single precision, with the (3 term) minimax polynomials of
+    // Cephes' sinf and cosf on [-pi/4, pi/4]: each sine is within 2 ULP (of a float)
+    // of sin(theta) for |theta| up to 8192, beyond which the reduction loses bits.
+    static const float TWO_OVER_PI_F = 6.36619772e-01f;
+    static const float PIO2_1F = 1.5703125f;                  //!< First 8 bits of pi/2
+    static const float PIO2_2F = 4.837512969970703125e-4f;    //!< Next 11 bits of pi/2
+    static const float PIO2_3F = 7.54978995489188216e-8f;     //!< pi/2 - (PIO2_1F + PIO2_2F)
+
+    static const float S1F = -1.6666654611e-1f;
+    static const float S2F = 8.3321608736e-3f;
+    static const float S3F = -1.9515295891e-4f;
+
+    static const float C1F = 4.166664568298827e-2f;
+    static const float C2F = -1.388731625493765e-3f;
+    static const float C3F = 2.443315711809948e-5f;
+}
+
+#endif
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include "fft.hh"
+#include "wave_field_snapshot.hh"
+
+#define PI (4.0 * std::atan(1.0))
+
+WaveFieldSnapshot::WaveFieldSnapshot(const WaveSpectrum& wave_spectrum,
+                                     const double x0, const double dx, const size_t nx,
+                                     const double y0, const double dy, const size_t ny,
+                                     const double t, WorkerPool& pool):
+    x0_(x0), dx_(dx), nx_(nx), y0_(y0), dy_(dy), ny_(ny), t_(t), z_(), synthesis_error_bound_(0), bilinear_error_bound_(0)
+{
+    if (nx < 2 || ny < 2 || not(is_power_of_two(nx)) || not(is_power_of_two(ny)))
+    {
+        throw std::invalid_argument("nx and ny should be powers of two (at least 2)");
+    }
+    if (not(dx > 0) || not(dy > 0))
+    {
+        throw std::invalid_argument("dx and dy should be strictly positive");
+    }
+    // Grid points are x0 + i.dx = xc + (i - nx/2).dx: moving a line to the wave vector p.dkx changes
+    // its phase by at most |kx - p.dkx|.nx/2.dx at the nodes, and the FFT sees exp(i.p.dkx.(i - nx/2).dx)
+    // = (-1)^p.exp(2i.pi.p.i/nx).
+    const double xc = x0 + static_cast<double>(nx / 2) * dx;
+    const double yc = y0 + static_cast<double>(ny / 2) * dy;
+    const double dkx = 2 * PI / (static_cast<double>(nx) * dx);
+    const double dky = 2 * PI / (static_cast<double>(ny) * dy);
+    const long half_nx = static_cast<long>(nx / 2);
+    const long half_ny = static_cast<long>(ny / 2);
+
+    // eta = -sum(a.sin(theta)) = Im(sum(-a.exp(i.theta)))
+    std::vector<std::complex<double> > c(nx * ny);
+    for (size_t line = 0; line < wave_spectrum.size(); ++line)
+    {
+        const double a = wave_spectrum.a()[line];
+        const double kx = wave_spectrum.k_cos_psi()[line];
+        const double ky = wave_spectrum.k_sin_psi()[line];
+        const long p = std::lround(kx / dkx);
+        const long q = std::lround(ky / dky);
+        if (std::abs(p) > half_nx || std::abs(q) > half_ny)
+        {
+            synthesis_error_bound_ += std::abs(a);
+            continue;
+        }
+        const double phase_at_center = kx * xc + ky * yc - wave_spectrum.omega()[line] * t + wave_spectrum.phase()[line];
+        const double amplitude = ((p + q) % 2 == 0) ? -a : a;
+        const size_t i = static_cast<size_t>((p + static_cast<long>(nx)) % static_cast<long>(nx));
+        const size_t j = static_cast<size_t>((q + static_cast<long>(ny)) % static_cast<long>(ny));
+        c[j * nx + i] += std::complex<double>(amplitude * std::cos(phase_at_center), amplitude * std::sin(phase_at_center));
+
+        const double phase_error = std::abs(kx - static_cast<double>(p) * dkx) * static_cast<double>(half_nx) * dx
+                                 + std::abs(ky - static_cast<double>(q) * dky) * static_cast<double>(half_ny) * dy;
+        synthesis_error_bound_ += std::abs(a) * std::min(2.0, phase_error);
+        const double kx_dx = static_cast<double>(p) * dkx * dx;
+        const double ky_dy = static_cast<double>(q) * dky * dy;
+        bilinear_error_bound_ += std::abs(a) * (kx_dx * kx_dx + ky_dy * ky_dy) / 8;
+    }
+
+    const Fft fft_x(nx, true);
+    const Fft fft_y(ny, true);
+    pool.parallel_for(ny, std::max(size_t(1), size_t(1 << 16) / nx), [&](const size_t begin, const size_t end)
+    {
+        for (size_t j = begin; j < end; ++j)
+        {
+            fft_x.transform(&c[j * nx]);
+        }
+    });
+    // Columns are gathered by blocks, so that each row segment read is a full cache line
+    const size_t block = std::min(nx, size_t(WAVE_FIELD_SNAPSHOT_COLUMN_BLOCK));
+    pool.parallel_for(nx / block, std::max(size_t(1), size_t(1 << 16) / (ny * block)), [&](const size_t begin, const size_t end)
+    {
+        std::vector<std::complex<double> > columns(block * ny);
+        for (size_t i0 = begin * block; i0 < end * block; i0 += block)
+        {
+            for (size_t j = 0; j < ny; ++j)
+            {
+                for (size_t i = 0; i < block; ++i)
+                {
+                    columns[i * ny + j] = c[j * nx + i0 + i];
+                }
+            }
+            for (size_t i = 0; i < block; ++i)
+            {
+                fft_y.transform(&columns[i * ny]);
+            }
+            for (size_t j = 0; j < ny; ++j)
+            {
+                for (size_t i = 0; i < block; ++i)
+                {
+                    c[j * nx + i0 + i] = columns[i * ny + j];
+                }
+            }
+        }
+    });
+    z_.resize(nx * ny);
+    for (size_t index = 0; index < nx * ny; ++index)
+    {
+        z_[index] = c[index].imag();
+    }
+}
+
+double WaveFieldSnapshot::interpolate(const double x, const double y) const
+{
+    const double u = (x - x0_) / dx_;
+    const double v = (y - y0_) / dy_;
+    if (not(u >= 0) || not(v >= 0) || u > static_cast<double>(nx_ - 1) || v > static_cast<double>(ny_ - 1))
+    {
+        throw std::invalid_argument("the interpolated points should be inside the snapshot grid");
+    }
+    const size_t i = std::min(static_cast<size_t>(u), nx_ - 2);
+    const size_t j = std::min(static_cast<size_t>(v), ny_ - 2);
+    const double fu = u - static_cast<double>(i);
+    const double fv = v - static_cast<double>(j);
+    const double* row = &z_[j * nx_ + i];
+    const double* next_row = row + nx_;
+    return (1 - fv) * ((1 - fu) * row[0] + fu * row[1]) + fv * ((1 - fu) * next_row[0] + fu * next_row[1]);
+}
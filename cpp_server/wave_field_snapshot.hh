@@ -0,0 +1,56 @@
+#ifndef WAVE_FIELD_SNAPSHOT_HH
+#define WAVE_FIELD_SNAPSHOT_HH
+
+#include <cstddef>
+#include <vector>
+#include "wave_spectrum.hh"
+#include "worker_pool.hh"
+
+// Number of columns of the grid transformed together (a power of two)
+#define WAVE_FIELD_SNAPSHOT_COLUMN_BLOCK 8
+
+// Free surface at t on the regular grid x0 + i.dx (i in [0, nx)), y0 + j.dy
+// (j in [0, ny)), synthesised with an inverse 2D FFT instead of the direct sum
+// over the spectrum lines: O(lines + nx.ny.log(nx.ny)) instead of O(lines.nx.ny).
+//
+// Each line is moved to the nearest wave vector of the FFT grid (a multiple of
+// 2.pi/(nx.dx) along x, of 2.pi/(ny.dy) along y), its phase being kept exact at
+// the center of the grid. The error this introduces grows with the distance to
+// the center and with the distance of the line to the FFT grid: it is zero when
+// the spectrum was discretised on the wave vectors of the grid, and bounded in
+// any case by synthesis_error_bound(). Lines beyond the Nyquist wave number of
+// the grid are left out (and counted in the bound). Up to round-off.
+class WaveFieldSnapshot
+{
+    public:
+        // Throws std::invalid_argument unless nx and ny are powers of two (at least 2) and dx, dy > 0
+        WaveFieldSnapshot(const WaveSpectrum& wave_spectrum,
+                          const double x0, const double dx, const size_t nx,
+                          const double y0, const double dy, const size_t ny,
+                          const double t, WorkerPool& pool);
+
+        const std::vector<double>& z() const {return z_;}   //!< Elevations, row by row: z[j.nx + i]
+        double t() const {return t_;}
+
+        // Upper bound (in m) of |z[j.nx + i] - compute_elevation(x0 + i.dx, y0 + j.dy, t)|
+        double synthesis_error_bound() const {return synthesis_error_bound_;}
+        // Upper bound (in m) of |interpolate(x, y) - compute_elevation(x, y, t)| inside the grid
+        double interpolation_error_bound() const {return synthesis_error_bound_ + bilinear_error_bound_;}
+
+        // Bilinear interpolation of z. Throws std::invalid_argument if (x, y) is outside the grid.
+        double interpolate(const double x, const double y) const;
+
+    private:
+        double x0_;
+        double dx_;
+        size_t nx_;
+        double y0_;
+        double dy_;
+        size_t ny_;
+        double t_;
+        std::vector<double> z_;
+        double synthesis_error_bound_;
+        double bilinear_error_bound_;   //!< sum(a.(kx^2.dx^2 + ky^2.dy^2))/8 over the lines of the FFT grid
+};
+
+#endif
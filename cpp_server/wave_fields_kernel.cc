@@ -0,0 +1,49 @@
+#include <cmath>
+#include "wave_fields_kernel.hh"
+
+void compute_wave_fields(const double* x, const double* y, const double* z, const size_t n, const double t,
+                         const WaveSpectrum& wave_spectrum,
+                         double* eta, double* pdyn, double* vx, double* vy, double* vz)
+{
+    const double* a = wave_spectrum.a();
+    const double* omega = wave_spectrum.omega();
+    const double* k = wave_spectrum.k();
+    const double* k_cos_psi = wave_spectrum.k_cos_psi();
+    const double* k_sin_psi = wave_spectrum.k_sin_psi();
+    const double* phase = wave_spectrum.phase();
+    const size_t size = wave_spectrum.size();
+
+    for (size_t index = 0; index < n; ++index)
+    {
+        double sum_sin = 0;         // sum(a.sin(theta))
+        double sum_f_sin = 0;       // sum(a.f.sin(theta))
+        double sum_f_sin_x = 0;     // sum(a/omega.f.sin(theta).k.cos(psi))
+        double sum_f_sin_y = 0;     // sum(a/omega.f.sin(theta).k.sin(psi))
+        double sum_f_cos = 0;       // sum(a.k/omega.f.cos(theta))
+        for (size_t line = 0; line < size; ++line)
+        {
+            const double theta = x[index] * k_cos_psi[line] + y[index] * k_sin_psi[line] - omega[line] * t + phase[line];
+            const double sin_theta = sin(theta);
+            const double cos_theta = cos(theta);
+            const double a_f = a[line] * exp(-k[line] * z[index]);
+            const double a_f_over_omega = a_f / omega[line];
+            sum_sin += a[line] * sin_theta;
+            sum_f_sin += a_f * sin_theta;
+            sum_f_sin_x += a_f_over_omega * sin_theta * k_cos_psi[line];
+            sum_f_sin_y += a_f_over_omega * sin_theta * k_sin_psi[line];
+            sum_f_cos += a_f_over_omega * k[line] * cos_theta;
+        }
+        eta[index] = -sum_sin;
+        if (eta[index] != 0 && z[index] < eta[index])
+        {
+            pdyn[index] = vx[index] = vy[index] = vz[index] = 0;
+        }
+        else
+        {
+            pdyn[index] = -WAVE_FIELDS_RHO * WAVE_FIELDS_G * sum_f_sin;
+            vx[index] = sum_f_sin_x;
+            vy[index] = sum_f_sin_y;
+            vz[index] = sum_f_cos;
+        }
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef WAVE_FIELDS_KERNEL_HH
+#define WAVE_FIELDS_KERNEL_HH
+
+#include <cstddef>
+#include "wave_spectrum.hh"
+
+#define WAVE_FIELDS_RHO 1000.0  //!< Water density (in kg/m^3)
+#define WAVE_FIELDS_G 9.81      //!< Gravity (in m/s^2)
+
+// Elevation, dynamic pressure and orbital velocity of linear waves in infinite
+// depth, for each point (x[i], y[i], z[i]) at t, with theta the phase of
+// compute_elevation (elevation_kernel.hh) and f = exp(-k.z):
+//     eta  = -sum(a.sin(theta))
+//     pdyn = -rho.g.sum(a.f.sin(theta))
+//     vx   = sum(a.k/omega.f.sin(theta).cos(psi)), vy likewise with sin(psi)
+//     vz   = sum(a.k/omega.f.cos(theta))
+// pdyn, vx, vy and vz are zero above the free surface (z < eta, eta != 0).
+//
+// All five are computed in a single pass over the spectrum lines: sin(theta),
+// cos(theta) and exp(-k.z) are evaluated once per (point, line) couple. As f
+// only vanishes when the whole point is above the surface, the sums are
+// accumulated unconditionally and cleared at the end once eta is known.
+void compute_wave_fields(const double* x, const double* y, const double* z, const size_t n, const double t,
+                         const WaveSpectrum& wave_spectrum,
+                         double* eta, double* pdyn, double* vx, double* vy, double* vz);
+
+#endif
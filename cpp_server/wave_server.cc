@@ -1,10 +1,22 @@
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <memory>
+#include <stdexcept>
 #include <vector>
 #include <string>
+#include <thread>
 #include <cmath>
 #include <grpcpp/grpcpp.h>
 #include "args.hxx"
+#include "async_server.hh"
+#include "directional_spectrum.hh"
+#include "elevation_handlers.hh"
+#include "elevation_kernel.hh"
+#include "prefetcher.hh"
+#include "wave_spectrum.hh"
+#include "wave_spectrum_file.hh"
+#include "worker_pool.hh"
 #include "wave.grpc.pb.h"
 
 #define PI (4.0 * std::atan(1.0))
@@ -13,6 +25,7 @@
 using grpc::Server;
 using grpc::ServerBuilder;
 using grpc::ServerContext;
+using grpc::ServerReaderWriter;
 using grpc::ServerWriter;
 using grpc::Status;
 using wave::Point;
@@ -21,147 +34,264 @@ using wave::ElevationResponse;
 using wave::ElevationPoint;
 using wave::ElevationRequestRepeated;
 using wave::ElevationResponseRepeated;
+using wave::ElevationResponseRepeatedFloat;
+using wave::ElevationRequestPacked;
+using wave::ElevationResponsePacked;
+using wave::ElevationSessionRequest;
+using wave::ElevationRequestGrid;
+using wave::ElevationRequestSnapshot;
+using wave::ElevationResponseSnapshot;
+using wave::ElevationRequestTimes;
+using wave::ElevationResponseTimes;
+using wave::ElevationRequestShared;
+using wave::ElevationResponseShared;
+using wave::SetWaveSpectrumRequest;
+using wave::SetWaveSpectrumResponse;
+using wave::ServerStatsRequest;
+using wave::ServerStatsResponse;
 using wave::ElevationService;
 using wave::FlatDiscreteDirectionalWaveSpectrum;
 using wave::WaveSpectrumLine;
 
-double compute_elevation(const double x, const double y, const double t, const FlatDiscreteDirectionalWaveSpectrum& wave_spectrum);
-double compute_elevation(const double x, const double y, const double t, const FlatDiscreteDirectionalWaveSpectrum& wave_spectrum)
-{
-    double result = 0;
-    for (const WaveSpectrumLine& spectrum_line : wave_spectrum.spectrum_lines())
-    {
-        result += - spectrum_line.a() * sin(
-                                        spectrum_line.k() * (x * cos(spectrum_line.psi()) + y * sin(spectrum_line.psi()))
-                                        - spectrum_line.omega() * t
-                                        + spectrum_line.phase()
-                                    );
-    }
-    return result;
-}
-
 class ElevationServiceImpl final : public ElevationService::Service {
     public:
-        explicit ElevationServiceImpl(const FlatDiscreteDirectionalWaveSpectrum& wave_spectrum):
-            wave_spectrum_(wave_spectrum) {}
+        explicit ElevationServiceImpl(ElevationHandlers& handlers):
+            handlers_(handlers) {}
 
         Status GetElevation(ServerContext* context, const ElevationRequest* request,
                             ElevationResponse* reply) override
         {
-            reply->clear_elevation_points();
-            reply->set_t(request->t());
-            for (const Point& point : request->points())
-            {
-                ElevationPoint* added_elevation_point = reply->add_elevation_points();
-                added_elevation_point->set_x(point.x());
-                added_elevation_point->set_y(point.y());
-                added_elevation_point->set_z(point.x() + point.y());
-            }
-
+            handlers_.get_elevation(*request, reply);
             return Status::OK;
         }
 
         Status GetElevationInputRepeated(ServerContext* context, const ElevationRequestRepeated* request,
                             ElevationResponse* reply) override
         {
-            reply->clear_elevation_points();
-            reply->set_t(request->t());
-            for (size_t index = 0; index < request->x_size(); ++index)
+            try
             {
-                ElevationPoint* added_elevation_point = reply->add_elevation_points();
-                added_elevation_point->set_x(request->x(index));
-                added_elevation_point->set_y(request->y(index));
-                added_elevation_point->set_z(request->x(index) + request->y(index));
+                handlers_.get_elevation_input_repeated(*request, reply);
+            }
+            catch (const std::invalid_argument& e)
+            {
+                return Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
             }
-
             return Status::OK;
         }
 
         Status GetElevationOutputRepeated(ServerContext* context, const ElevationRequest* request,
                             ElevationResponseRepeated* reply) override
         {
-            reply->clear_z();
-            reply->clear_x(); reply->clear_y();
-            reply->set_t(request->t());
-            for (const Point& point : request->points())
-            {
-                reply->add_x(point.x());
-                reply->add_y(point.y());
-                reply->add_z(point.x() + point.y());
-            }
-
+            handlers_.get_elevation_output_repeated(*request, reply);
             return Status::OK;
         }
 
         Status GetElevationRepeated(ServerContext* context, const ElevationRequestRepeated* request,
                             ElevationResponseRepeated* reply) override
         {
-            reply->clear_z();
-            reply->clear_x(); reply->clear_y();
-            reply->set_t(request->t());
-            for (size_t index = 0; index < request->x_size(); ++index)
+            try
             {
-                reply->add_x(request->x(index));
-                reply->add_y(request->y(index));
-                reply->add_z(request->x(index) + request->y(index));
+                handlers_.get_elevation_repeated(*request, reply);
+            }
+            catch (const std::invalid_argument& e)
+            {
+                return Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
             }
-
             return Status::OK;
         }
 
         Status GetElevationOutputRepeatedZ(ServerContext* context, const ElevationRequest* request,
                             ElevationResponseRepeated* reply) override
         {
-            reply->clear_z();
-            reply->set_t(request->t());
-            for (const Point& point : request->points())
+            handlers_.get_elevation_output_repeated_z(*request, reply);
+            return Status::OK;
+        }
+
+        Status GetElevationRepeatedZ(ServerContext* context, const ElevationRequestRepeated* request,
+                            ElevationResponseRepeated* reply) override
+        {
+            try
             {
-                reply->add_z(point.x() + point.y());
+                handlers_.get_elevation_repeated_z(*request, reply);
             }
+            catch (const std::invalid_argument& e)
+            {
+                return Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+            }
+            return Status::OK;
+        }
 
+        Status GetElevationRepeatedFloat(ServerContext* context, const ElevationRequestRepeated* request,
+                            ElevationResponseRepeatedFloat* reply) override
+        {
+            try
+            {
+                handlers_.get_elevation_repeated_float(*request, reply);
+            }
+            catch (const std::invalid_argument& e)
+            {
+                return Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+            }
             return Status::OK;
         }
 
-        Status GetElevationRepeatedZ(ServerContext* context, const ElevationRequestRepeated* request,
-                            ElevationResponseRepeated* reply) override
+        Status GetElevationPacked(ServerContext* context, const ElevationRequestPacked* request,
+                            ElevationResponsePacked* reply) override
         {
-            reply->clear_z();
-            reply->set_t(request->t());
-            for (size_t index = 0; index < request->x_size(); ++index)
+            try
+            {
+                handlers_.get_elevation_packed(*request, reply);
+            }
+            catch (const std::invalid_argument& e)
             {
-                reply->add_z(request->x(index) + request->y(index));
+                return Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
             }
+            return Status::OK;
+        }
 
+        Status GetElevationPackedZ(ServerContext* context, const ElevationRequestPacked* request,
+                            ElevationResponsePacked* reply) override
+        {
+            try
+            {
+                handlers_.get_elevation_packed_z(*request, reply);
+            }
+            catch (const std::invalid_argument& e)
+            {
+                return Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+            }
             return Status::OK;
         }
 
         Status GetElevations(ServerContext* context, const ElevationRequest* request,
                             ServerWriter<ElevationResponse>* writer) override
         {
-            ElevationResponse elevation;
-            if (request->dt() > 0 && request->t_end() - request->t_start() > 0)
+            // The next message is computed while the current one is written (Write blocks
+            // while the client is not reading). Stops as soon as the client is gone.
+            std::unique_ptr<ElevationStream> stream;
+            try
+            {
+                stream.reset(new ElevationStream(handlers_, *request));
+            }
+            catch (const std::invalid_argument& e)
+            {
+                return Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+            }
+            Prefetcher<ElevationResponse> messages([&stream](ElevationResponse* message) {return stream->next(message);});
+            while (const ElevationResponse* message = messages.next())
+            {
+                if (context->IsCancelled() || not(writer->Write(*message)))
+                {
+                    return Status(grpc::StatusCode::CANCELLED, "the stream was cancelled");
+                }
+            }
+            return Status::OK;
+        }
+
+        Status GetElevationGrid(ServerContext* context, const ElevationRequestGrid* request,
+                            ElevationResponseRepeated* reply) override
+        {
+            try
+            {
+                handlers_.get_elevation_grid(*request, reply);
+            }
+            catch (const std::invalid_argument& e)
+            {
+                return Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+            }
+            return Status::OK;
+        }
+
+        Status GetElevationSnapshot(ServerContext* context, const ElevationRequestSnapshot* request,
+                            ElevationResponseSnapshot* reply) override
+        {
+            try
+            {
+                handlers_.get_elevation_snapshot(*request, reply);
+            }
+            catch (const std::invalid_argument& e)
+            {
+                return Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+            }
+            return Status::OK;
+        }
+
+        Status GetElevationTimes(ServerContext* context, const ElevationRequestTimes* request,
+                            ElevationResponseTimes* reply) override
+        {
+            try
+            {
+                handlers_.get_elevation_times(*request, reply);
+            }
+            catch (const std::invalid_argument& e)
+            {
+                return Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+            }
+            return Status::OK;
+        }
+
+        Status GetElevationShared(ServerContext* context, const ElevationRequestShared* request,
+                            ElevationResponseShared* reply) override
+        {
+            try
             {
-                const double count = (request->t_end() - request->t_start()) / request->dt();
-                for (size_t index = 0; index <= count; ++index)
+                handlers_.get_elevation_shared(*request, reply);
+            }
+            catch (const std::invalid_argument& e)
+            {
+                return Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+            }
+            return Status::OK;
+        }
+
+        Status SetWaveSpectrum(ServerContext* context, const SetWaveSpectrumRequest* request,
+                            SetWaveSpectrumResponse* reply) override
+        {
+            try
+            {
+                handlers_.set_wave_spectrum(*request, reply);
+            }
+            catch (const std::invalid_argument& e)
+            {
+                return Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+            }
+            std::cout << "Wave spectrum replaced: " << reply->number_of_lines() << " line(s)" << std::endl;
+            return Status::OK;
+        }
+
+        Status GetServerStats(ServerContext* context, const ServerStatsRequest* request,
+                            ServerStatsResponse* reply) override
+        {
+            handlers_.get_server_stats(*request, reply);
+            return Status::OK;
+        }
+
+        Status ElevationSession(ServerContext* context,
+                            ServerReaderWriter<ElevationResponseRepeated, ElevationSessionRequest>* stream) override
+        {
+            PointSetSession session(handlers_);
+            ElevationSessionRequest request;
+            ElevationResponseRepeated reply;
+            while (stream->Read(&request))
+            {
+                try
+                {
+                    session.next(request, &reply);
+                }
+                catch (const std::invalid_argument& e)
+                {
+                    return Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+                }
+                if (not(stream->Write(reply)))
                 {
-                    const double t = request->t_start() + index * request->dt();
-                    elevation.clear_elevation_points();
-                    elevation.set_t(t);
-                    for (const Point& point : request->points())
-                    {
-                        ElevationPoint* added_elevation_point = elevation.add_elevation_points();
-                        added_elevation_point->set_x(point.x());
-                        added_elevation_point->set_y(point.y());
-                        added_elevation_point->set_z(compute_elevation(point.x(), point.y(), t, wave_spectrum_));
-                    }
-                    writer->Write(elevation);
+                    return Status(grpc::StatusCode::CANCELLED, "the session was cancelled");
                 }
             }
             return Status::OK;
         }
 
     private:
-        FlatDiscreteDirectionalWaveSpectrum wave_spectrum_;
+        ElevationHandlers& handlers_;
 };
 
 void compute_wave_spectrum(FlatDiscreteDirectionalWaveSpectrum& wave_spectrum, const bool& use_full_spectrum);
@@ -203,12 +333,35 @@ void compute_wave_spectrum(FlatDiscreteDirectionalWaveSpectrum& wave_spectrum, c
     }
 }
 
-void run_server(const FlatDiscreteDirectionalWaveSpectrum& wave_spectrum);
-void run_server(const FlatDiscreteDirectionalWaveSpectrum& wave_spectrum)
+void run_server(const WaveSpectrum& wave_spectrum, const size_t number_of_threads, const bool use_async_server,
+                const size_t cache_size_in_mib, const std::chrono::microseconds batch_window, const std::string& spectrum_directory);
+void run_server(const WaveSpectrum& wave_spectrum, const size_t number_of_threads, const bool use_async_server,
+                const size_t cache_size_in_mib, const std::chrono::microseconds batch_window, const std::string& spectrum_directory)
 {
     std::string server_address("0.0.0.0:50051");
-    ElevationServiceImpl service(wave_spectrum);
+    WorkerPool pool(number_of_threads);
+    ElevationHandlers handlers(wave_spectrum, pool, cache_size_in_mib << 20, batch_window, spectrum_directory);
+    if (cache_size_in_mib > 0)
+    {
+        std::cout << "Elevation cache: " << cache_size_in_mib << " MiB" << std::endl;
+    }
+    if (batch_window.count() > 0)
+    {
+        std::cout << "Request batching: " << batch_window.count() << " us window" << std::endl;
+    }
+    if (not(spectrum_directory.empty()))
+    {
+        std::cout << "Spectrum directory: " << spectrum_directory << std::endl;
+    }
+    std::cout << "Elevation kernel: " << to_string(best_elevation_kernel_isa()) << " on " << pool.size() << " thread(s)" << std::endl;
 
+    if (use_async_server)
+    {
+        run_async_server(server_address, handlers, std::max(std::thread::hardware_concurrency(), 1u));
+        return;
+    }
+
+    ElevationServiceImpl service(handlers);
     ServerBuilder builder;
     builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
     builder.RegisterService(&service);
@@ -222,6 +375,13 @@ int main(int argc, char** argv)
     args::ArgumentParser parser("This is a test grpc server demo program.", "Enjoy.");
     args::HelpFlag help(parser, "help", "Display this help menu", {'h', "help"});
     args::ValueFlag<std::string> input_use_full_spectrum(parser, "spectrum", "'y' if you wish to use a 128 line discrete wave spectrum, anything else if you want a 1 line one.", {'s', "spectrum"});
+    args::ValueFlag<std::string> input_spectrum_file(parser, "spectrum-file", "Binary wave spectrum file (see wave_spectrum_converter), mapped in memory. Overrides --spectrum.", {"spectrum-file"});
+    args::ValueFlag<std::string> input_spectrum_directory(parser, "spectrum-directory", "Directory of the binary wave spectrum files SetWaveSpectrum can map, given relative to it (none by default: SetWaveSpectrum only takes spectrum lines).", {"spectrum-directory"});
+    args::Flag input_use_async_server(parser, "async", "Use gRPC's asynchronous API (one completion queue polled by one thread per core) instead of the synchronous one.", {'a', "async"});
+    args::ValueFlag<int> input_number_of_threads(parser, "threads", "Number of threads computing the elevations of a large request (1 by default: everything is computed on the gRPC handler thread).", {'t', "threads"});
+    args::ValueFlag<double> input_pruning(parser, "prune", "Drops the weakest lines of the spectrum, as long as they hold less than this fraction of its variance (0 by default: every line is kept).", {"prune"});
+    args::ValueFlag<int> input_cache_size(parser, "cache", "Memory (in MiB) used to cache the elevations of recent requests, keyed by t and by their points (0 by default: no cache).", {'c', "cache"});
+    args::ValueFlag<int> input_batch_window(parser, "batch-window", "Time (in microseconds) a small request waits for the requests of other clients at the same t, to compute them all at once (0 by default: no batching). Not available with --async.", {"batch-window"});
     try
     {
         parser.ParseCLI(argc, argv);
@@ -256,10 +416,86 @@ int main(int argc, char** argv)
       std::cout << "use full wave spectrum: " << (use_full_spectrum ? "yes" : "no") << std::endl;
     }
 
-    FlatDiscreteDirectionalWaveSpectrum wave_spectrum;
-    compute_wave_spectrum(wave_spectrum, use_full_spectrum);
+    size_t number_of_threads(1);
+    if (input_number_of_threads)
+    {
+        if (args::get(input_number_of_threads) < 1)
+        {
+            std::cerr << "The number of threads should be at least 1." << std::endl;
+            return 1;
+        }
+        number_of_threads = static_cast<size_t>(args::get(input_number_of_threads));
+    }
+
+    std::unique_ptr<WaveSpectrum> wave_spectrum;
+    if (input_spectrum_file)
+    {
+        try
+        {
+            wave_spectrum.reset(new WaveSpectrum(map_wave_spectrum_file(args::get(input_spectrum_file))));
+        }
+        catch (const std::invalid_argument& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        std::cout << "Wave spectrum file: " << args::get(input_spectrum_file) << " (" << wave_spectrum->size() << " lines)" << std::endl;
+    }
+    else
+    {
+        FlatDiscreteDirectionalWaveSpectrum wave_spectrum_lines;
+        compute_wave_spectrum(wave_spectrum_lines, use_full_spectrum);
+        wave_spectrum.reset(new WaveSpectrum(to_wave_spectrum(wave_spectrum_lines)));
+    }
+
+    size_t cache_size_in_mib(0);
+    if (input_cache_size)
+    {
+        if (args::get(input_cache_size) < 0)
+        {
+            std::cerr << "The size of the cache should be positive." << std::endl;
+            return 1;
+        }
+        cache_size_in_mib = static_cast<size_t>(args::get(input_cache_size));
+    }
+
+    std::chrono::microseconds batch_window(0);
+    if (input_batch_window)
+    {
+        if (args::get(input_batch_window) < 0)
+        {
+            std::cerr << "The batching window should be positive." << std::endl;
+            return 1;
+        }
+        batch_window = std::chrono::microseconds(args::get(input_batch_window));
+    }
+    if (input_use_async_server && batch_window.count() > 0)
+    {
+        // The first request of a batch waits in its handler: with --async, that would stall a completion queue thread
+        std::cerr << "Request batching (--batch-window) is only available with the synchronous server (without --async)." << std::endl;
+        return 1;
+    }
+
+    if (input_pruning)
+    {
+        SpectrumLines lines(*wave_spectrum);
+        PruningReport report;
+        try
+        {
+            report = prune_spectrum_lines(lines, args::get(input_pruning));
+        }
+        catch (const std::invalid_argument& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        wave_spectrum.reset(new WaveSpectrum(lines.to_wave_spectrum()));
+        std::cout << "Pruned " << report.dropped_lines << " spectrum line(s) out of " << report.dropped_lines + report.kept_lines
+                  << ": elevation error below " << report.max_elevation_error << " m (" << std::sqrt(report.dropped_variance) << " m RMS)" << std::endl;
+    }
 
-    run_server(wave_spectrum);
+    run_server(*wave_spectrum, number_of_threads, input_use_async_server, cache_size_in_mib, batch_window,
+               input_spectrum_directory ? args::get(input_spectrum_directory) : std::string());
 
     return 0;
 }
@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <string>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+#include "wave_spectrum.hh"
+
+const size_t WaveSpectrum::alignment;
+const size_t WaveSpectrum::line_padding;
+
+double* allocate_aligned(const size_t size);
+double* allocate_aligned(const size_t size)
+{
+    void* memory = nullptr;
+#ifdef _MSC_VER
+    memory = _aligned_malloc(size * sizeof(double), WaveSpectrum::alignment);
+#else
+    if (posix_memalign(&memory, WaveSpectrum::alignment, size * sizeof(double)) != 0)
+    {
+        memory = nullptr;
+    }
+#endif
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return static_cast<double*>(memory);
+}
+
+void free_aligned(double* memory);
+void free_aligned(double* memory)
+{
+#ifdef _MSC_VER
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+WaveSpectrum::WaveSpectrum(const std::vector<double>& a,
+                           const std::vector<double>& omega,
+                           const std::vector<double>& psi,
+                           const std::vector<double>& k,
+                           const std::vector<double>& phase):
+    size_(a.size()),
+    padded_size_(padded_size_of(a.size())),
+    storage_(),
+    a_(nullptr), omega_(nullptr), psi_(nullptr), k_(nullptr),
+    k_cos_psi_(nullptr), k_sin_psi_(nullptr), phase_(nullptr)
+{
+    if (omega.size() != size_ || psi.size() != size_ || k.size() != size_ || phase.size() != size_)
+    {
+        throw std::invalid_argument("WaveSpectrum: a, omega, psi, k and phase should all have the same size");
+    }
+    // padded_size_ is a multiple of line_padding doubles, i.e. of the alignment:
+    // every array of the block therefore starts on an aligned address.
+    const size_t number_of_arrays = 7;
+    const size_t block_size = std::max(number_of_arrays * padded_size_, size_t(1));
+    const std::shared_ptr<double> storage(allocate_aligned(block_size), free_aligned);
+    storage_ = storage;
+    double* block = storage.get();
+    std::fill(block, block + block_size, 0.0);
+
+    double* a_array         = block;
+    double* omega_array     = block + 1 * padded_size_;
+    double* psi_array       = block + 2 * padded_size_;
+    double* k_array         = block + 3 * padded_size_;
+    double* k_cos_psi_array = block + 4 * padded_size_;
+    double* k_sin_psi_array = block + 5 * padded_size_;
+    double* phase_array     = block + 6 * padded_size_;
+    for (size_t index = 0; index < size_; ++index)
+    {
+        a_array[index] = a[index];
+        omega_array[index] = omega[index];
+        psi_array[index] = psi[index];
+        k_array[index] = k[index];
+        k_cos_psi_array[index] = k[index] * std::cos(psi[index]);
+        k_sin_psi_array[index] = k[index] * std::sin(psi[index]);
+        phase_array[index] = phase[index];
+    }
+    a_ = a_array;
+    omega_ = omega_array;
+    psi_ = psi_array;
+    k_ = k_array;
+    k_cos_psi_ = k_cos_psi_array;
+    k_sin_psi_ = k_sin_psi_array;
+    phase_ = phase_array;
+}
+
+WaveSpectrum::WaveSpectrum(const size_t size, const std::shared_ptr<const double>& block):
+    size_(size),
+    padded_size_(padded_size_of(size)),
+    storage_(block),
+    a_(block.get()),
+    omega_(block.get() + 1 * padded_size_),
+    psi_(block.get() + 2 * padded_size_),
+    k_(block.get() + 3 * padded_size_),
+    k_cos_psi_(block.get() + 4 * padded_size_),
+    k_sin_psi_(block.get() + 5 * padded_size_),
+    phase_(block.get() + 6 * padded_size_)
+{
+    if (reinterpret_cast<uintptr_t>(block.get()) % alignment != 0)
+    {
+        throw std::invalid_argument("WaveSpectrum: the arrays should be aligned on " + std::to_string(alignment) + " bytes");
+    }
+}
+
+size_t WaveSpectrum::padded_size_of(const size_t size)
+{
+    return ((size + line_padding - 1) / line_padding) * line_padding;
+}
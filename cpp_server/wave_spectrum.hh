@@ -0,0 +1,60 @@
+#ifndef WAVE_SPECTRUM_HH
+#define WAVE_SPECTRUM_HH
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Discrete directional wave spectrum stored as a structure of arrays.
+//
+// Everything that does not depend on the point or on the time is computed once
+// when the spectrum is built (in particular k.cos(psi) and k.sin(psi)), so that
+// the elevation kernels only have to read contiguous arrays. Each array starts
+// on a WaveSpectrum::alignment boundary and is padded with zero-amplitude lines
+// up to padded_size(): padding lines contribute nothing to the elevation, so
+// vectorized kernels can process the lines by full registers.
+class WaveSpectrum
+{
+    public:
+        static const size_t alignment = 64;     //!< Alignment (in bytes) of each array
+        static const size_t line_padding = 8;   //!< padded_size() is a multiple of this
+
+        WaveSpectrum(const std::vector<double>& a,
+                     const std::vector<double>& omega,
+                     const std::vector<double>& psi,
+                     const std::vector<double>& k,
+                     const std::vector<double>& phase);
+        // Spectrum of size lines whose arrays are already laid out in block, e.g. a
+        // memory-mapped spectrum file (see wave_spectrum_file.hh): a, omega, psi, k,
+        // k.cos(psi), k.sin(psi) and phase, in that order, each of padded_size_of(size)
+        // values. Nothing is copied: block is kept alive as long as the spectrum.
+        // Throws std::invalid_argument if block is not aligned on WaveSpectrum::alignment.
+        WaveSpectrum(const size_t size, const std::shared_ptr<const double>& block);
+
+        static size_t padded_size_of(const size_t size); //!< Number of lines including the padding, for size lines
+
+        size_t size() const {return size_;}               //!< Number of spectrum lines
+        size_t padded_size() const {return padded_size_;} //!< Number of lines including the zero-amplitude padding
+
+        const double* a() const {return a_;}                 //!< Amplitude (in m)
+        const double* omega() const {return omega_;}         //!< Angular frequency (in rad/s)
+        const double* psi() const {return psi_;}             //!< Direction (in rad)
+        const double* k() const {return k_;}                 //!< Wave number (in rad/m)
+        const double* k_cos_psi() const {return k_cos_psi_;} //!< k.cos(psi) (in rad/m)
+        const double* k_sin_psi() const {return k_sin_psi_;} //!< k.sin(psi) (in rad/m)
+        const double* phase() const {return phase_;}         //!< Random phase (in rad)
+
+    private:
+        size_t size_;
+        size_t padded_size_;
+        std::shared_ptr<const double> storage_;
+        const double* a_;
+        const double* omega_;
+        const double* psi_;
+        const double* k_;
+        const double* k_cos_psi_;
+        const double* k_sin_psi_;
+        const double* phase_;
+};
+
+#endif
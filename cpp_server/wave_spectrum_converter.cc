@@ -0,0 +1,66 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "args.hxx"
+#include "wave_spectrum_file.hh"
+#include "wave_spectrum_yaml.hh"
+
+// Converts a wave spectrum given line by line in YAML or JSON (see wave_spectrum_yaml.hh)
+// into the binary file mapped by wave_server --spectrum-file (see wave_spectrum_file.hh).
+int main(int argc, char** argv)
+{
+    args::ArgumentParser parser("Converts a YAML or JSON wave spectrum (lists a, omega, psi, k and phase) into a binary spectrum file for wave_server --spectrum-file.", "Enjoy.");
+    args::HelpFlag help(parser, "help", "Display this help menu", {'h', "help"});
+    args::Positional<std::string> input_path(parser, "input", "YAML or JSON wave spectrum", args::Options::Required);
+    args::Positional<std::string> output_path(parser, "output", "Binary wave spectrum file (replaced if it exists)", args::Options::Required);
+    try
+    {
+        parser.ParseCLI(argc, argv);
+    }
+    catch (args::Help)
+    {
+        std::cout << parser;
+        return 0;
+    }
+    catch (const args::ParseError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    catch (const args::ValidationError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "An internal error has occurred: " << e.what() << std::endl;
+        return -1;
+    }
+
+    std::ifstream input(args::get(input_path).c_str());
+    if (not(input))
+    {
+        std::cerr << "Unable to open " << args::get(input_path) << std::endl;
+        return 1;
+    }
+    std::stringstream yaml;
+    yaml << input.rdbuf();
+    try
+    {
+        write_wave_spectrum_file(parse_wave_spectrum(yaml.str()), args::get(output_path));
+        // Checks the file the way wave_server will read it
+        const WaveSpectrum wave_spectrum = map_wave_spectrum_file(args::get(output_path));
+        std::cout << args::get(output_path) << ": " << wave_spectrum.size() << " lines" << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
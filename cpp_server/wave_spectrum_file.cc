@@ -0,0 +1,154 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#ifdef _MSC_VER
+#include <malloc.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "wave_spectrum_file.hh"
+
+static_assert(sizeof(WaveSpectrumFileHeader) == WAVE_SPECTRUM_FILE_HEADER_SIZE, "WaveSpectrumFileHeader should not be padded");
+static_assert(WAVE_SPECTRUM_FILE_HEADER_SIZE % WaveSpectrum::alignment == 0, "The arrays should stay aligned after the header");
+
+#define WAVE_SPECTRUM_FILE_MAGIC "WAVESPEC"
+#define WAVE_SPECTRUM_FILE_BYTE_ORDER_MARK 0x01020304u
+
+void write_wave_spectrum_file(const WaveSpectrum& wave_spectrum, const std::string& path)
+{
+    WaveSpectrumFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, WAVE_SPECTRUM_FILE_MAGIC, sizeof(header.magic));
+    header.version = WAVE_SPECTRUM_FILE_VERSION;
+    header.byte_order_mark = WAVE_SPECTRUM_FILE_BYTE_ORDER_MARK;
+    header.number_of_lines = wave_spectrum.size();
+    header.padded_number_of_lines = wave_spectrum.padded_size();
+
+    // Written next to path then renamed: a server mapping the previous file keeps its pages
+    const std::string temporary_path = path + ".tmp";
+    std::ofstream file(temporary_path.c_str(), std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    const double* arrays[] = {wave_spectrum.a(), wave_spectrum.omega(), wave_spectrum.psi(), wave_spectrum.k(),
+                              wave_spectrum.k_cos_psi(), wave_spectrum.k_sin_psi(), wave_spectrum.phase()};
+    for (const double* array : arrays)
+    {
+        file.write(reinterpret_cast<const char*>(array), static_cast<std::streamsize>(wave_spectrum.padded_size() * sizeof(double)));
+    }
+    file.close();
+    if (not(file) || std::rename(temporary_path.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporary_path.c_str());
+        throw std::runtime_error("Unable to write the wave spectrum file " + path);
+    }
+}
+
+// Number of bytes of a valid file with this header (throws if the header is invalid)
+size_t wave_spectrum_file_size(const WaveSpectrumFileHeader& header, const size_t file_size, const std::string& path);
+size_t wave_spectrum_file_size(const WaveSpectrumFileHeader& header, const size_t file_size, const std::string& path)
+{
+    if (std::memcmp(header.magic, WAVE_SPECTRUM_FILE_MAGIC, sizeof(header.magic)) != 0)
+    {
+        throw std::invalid_argument(path + " is not a wave spectrum file");
+    }
+    if (header.byte_order_mark != WAVE_SPECTRUM_FILE_BYTE_ORDER_MARK)
+    {
+        throw std::invalid_argument(path + " was written on a machine with another byte order");
+    }
+    if (header.version != WAVE_SPECTRUM_FILE_VERSION)
+    {
+        throw std::invalid_argument(path + " has version " + std::to_string(header.version) + " of the wave spectrum file format, instead of "
+                                    + std::to_string(WAVE_SPECTRUM_FILE_VERSION));
+    }
+    if (header.number_of_lines == 0 || header.padded_number_of_lines != WaveSpectrum::padded_size_of(header.number_of_lines)
+        || header.padded_number_of_lines > (file_size - sizeof(header)) / (7 * sizeof(double)))
+    {
+        throw std::invalid_argument(path + " has an inconsistent number of lines");
+    }
+    const size_t expected_size = sizeof(header) + 7 * header.padded_number_of_lines * sizeof(double);
+    if (file_size != expected_size)
+    {
+        throw std::invalid_argument(path + " should be " + std::to_string(expected_size) + " bytes long");
+    }
+    return expected_size;
+}
+
+// The padding lines should not contribute to the elevations
+void check_padding(const WaveSpectrum& wave_spectrum, const std::string& path);
+void check_padding(const WaveSpectrum& wave_spectrum, const std::string& path)
+{
+    for (size_t index = wave_spectrum.size(); index < wave_spectrum.padded_size(); ++index)
+    {
+        if (wave_spectrum.a()[index] != 0)
+        {
+            throw std::invalid_argument(path + " has padding lines with a non-zero amplitude");
+        }
+    }
+}
+
+#ifndef _MSC_VER
+WaveSpectrum map_wave_spectrum_file(const std::string& path)
+{
+    const int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        throw std::invalid_argument("Unable to open the wave spectrum file " + path + ": " + std::strerror(errno));
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(WaveSpectrumFileHeader))
+    {
+        close(descriptor);
+        throw std::invalid_argument(path + " is not a wave spectrum file");
+    }
+    const size_t file_size = static_cast<size_t>(status.st_size);
+    void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, descriptor, 0);
+    // The mapping stays valid once the descriptor is closed
+    close(descriptor);
+    if (mapping == MAP_FAILED)
+    {
+        throw std::invalid_argument("Unable to map the wave spectrum file " + path + ": " + std::strerror(errno));
+    }
+    const char* bytes = static_cast<const char*>(mapping);
+    // Unmaps the whole file once the spectrum, and all its copies, are gone
+    const std::shared_ptr<const double> block(reinterpret_cast<const double*>(bytes + sizeof(WaveSpectrumFileHeader)),
+                                              [mapping, file_size](const double*) {munmap(mapping, file_size);});
+    WaveSpectrumFileHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+    wave_spectrum_file_size(header, file_size, path);
+    const WaveSpectrum wave_spectrum(static_cast<size_t>(header.number_of_lines), block);
+    check_padding(wave_spectrum, path);
+    return wave_spectrum;
+}
+#else
+// No mmap: the file is read at once into aligned memory
+WaveSpectrum map_wave_spectrum_file(const std::string& path)
+{
+    std::ifstream file(path.c_str(), std::ios::binary | std::ios::ate);
+    if (not(file))
+    {
+        throw std::invalid_argument("Unable to open the wave spectrum file " + path);
+    }
+    const size_t file_size = static_cast<size_t>(file.tellg());
+    WaveSpectrumFileHeader header;
+    file.seekg(0);
+    if (file_size < sizeof(header) || not(file.read(reinterpret_cast<char*>(&header), sizeof(header))))
+    {
+        throw std::invalid_argument(path + " is not a wave spectrum file");
+    }
+    const size_t size = wave_spectrum_file_size(header, file_size, path) - sizeof(header);
+    const std::shared_ptr<double> block(static_cast<double*>(_aligned_malloc(size, WaveSpectrum::alignment)), _aligned_free);
+    if (not(block) || not(file.read(reinterpret_cast<char*>(block.get()), static_cast<std::streamsize>(size))))
+    {
+        throw std::invalid_argument("Unable to read the wave spectrum file " + path);
+    }
+    const WaveSpectrum wave_spectrum(static_cast<size_t>(header.number_of_lines), block);
+    check_padding(wave_spectrum, path);
+    return wave_spectrum;
+}
+#endif
@@ -0,0 +1,46 @@
+#ifndef WAVE_SPECTRUM_FILE_HH
+#define WAVE_SPECTRUM_FILE_HH
+
+#include <cstdint>
+#include <string>
+#include "wave_spectrum.hh"
+
+#define WAVE_SPECTRUM_FILE_VERSION 1
+#define WAVE_SPECTRUM_FILE_HEADER_SIZE 64
+
+// Binary spectrum file: the memory layout of WaveSpectrum, so that the server
+// can map the file and hand it to the elevation kernels as is (no parsing, no copy).
+//
+// All values are in the byte order of the machine that wrote the file (checked
+// when reading it, through byte_order_mark):
+//     offset  0: char[8]   "WAVESPEC"
+//     offset  8: uint32    format version (WAVE_SPECTRUM_FILE_VERSION)
+//     offset 12: uint32    byte order mark 0x01020304
+//     offset 16: uint64    number of lines n
+//     offset 24: uint64    padded number of lines p (WaveSpectrum::padded_size_of(n))
+//     offset 32: zeros     up to WAVE_SPECTRUM_FILE_HEADER_SIZE
+//     offset 64: double[p] a, then omega, psi, k, k.cos(psi), k.sin(psi) and phase
+// Lines n to p - 1 are padding, with a zero amplitude. Every array is therefore
+// aligned on 64 bytes in the mapping.
+struct WaveSpectrumFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order_mark;
+    uint64_t number_of_lines;
+    uint64_t padded_number_of_lines;
+    char reserved[WAVE_SPECTRUM_FILE_HEADER_SIZE - 32];
+};
+
+// The file is replaced atomically (written under another name, then renamed): it
+// must never be modified in place while a server maps it.
+// Throws std::runtime_error if the file cannot be written.
+void write_wave_spectrum_file(const WaveSpectrum& wave_spectrum, const std::string& path);
+
+// Maps the file read-only: the pages are loaded on first access and shared by
+// all the processes mapping the same file. The mapping is released with the last
+// copy of the spectrum. Throws std::invalid_argument if the file cannot be read
+// or is not a valid spectrum file.
+WaveSpectrum map_wave_spectrum_file(const std::string& path);
+
+#endif
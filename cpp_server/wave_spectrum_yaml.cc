@@ -0,0 +1,32 @@
+#include <stdexcept>
+#include <vector>
+#include <yaml-cpp/yaml.h>
+#include "wave_spectrum_yaml.hh"
+#include "yaml_value.hh"
+
+WaveSpectrum parse_wave_spectrum(const std::string& yaml)
+{
+    YAML::Node node;
+    try
+    {
+        node = YAML::Load(yaml);
+    }
+    catch (const YAML::Exception& e)
+    {
+        throw std::invalid_argument(std::string("Invalid YAML: ") + e.what());
+    }
+    if (not(node.IsMap()))
+    {
+        throw std::invalid_argument("The wave spectrum should be a YAML map.");
+    }
+    const std::vector<double> a = get_yaml_value<std::vector<double> >(node, "a");
+    if (a.empty())
+    {
+        throw std::invalid_argument("The wave spectrum should have at least one line.");
+    }
+    return WaveSpectrum(a,
+                        get_yaml_value<std::vector<double> >(node, "omega"),
+                        get_yaml_value<std::vector<double> >(node, "psi"),
+                        get_yaml_value<std::vector<double> >(node, "k"),
+                        get_yaml_value<std::vector<double> >(node, "phase"));
+}
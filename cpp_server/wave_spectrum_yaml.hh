@@ -0,0 +1,16 @@
+#ifndef WAVE_SPECTRUM_YAML_HH
+#define WAVE_SPECTRUM_YAML_HH
+
+#include <string>
+#include "wave_spectrum.hh"
+
+// Discrete wave spectrum given line by line in YAML, as accepted by SetWaveSpectrum:
+//     a: [0.5, 0.25]          # amplitudes (in m)
+//     omega: [0.6, 0.7]       # angular frequencies (in rad/s)
+//     psi: [0, 1.57]          # directions (in rad)
+//     k: [0.037, 0.05]        # wave numbers (in rad/m)
+//     phase: [0, 3.14]        # phases (in rad)
+// Throws std::invalid_argument if a list is missing, or if they do not all have the same (non zero) size.
+WaveSpectrum parse_wave_spectrum(const std::string& yaml);
+
+#endif
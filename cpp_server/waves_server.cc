@@ -0,0 +1,280 @@
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <grpcpp/grpcpp.h>
+#include "args.hxx"
+#include "airy.hh"
+#include "elevation_kernel.hh"
+#include "published_pointer.hh"
+#include "worker_pool.hh"
+#include "wave_grpc.grpc.pb.h"
+
+using grpc::Server;
+using grpc::ServerBuilder;
+using grpc::ServerContext;
+using grpc::Status;
+using grpc::StatusCode;
+
+// Native implementation of the Waves service (wave_grpc.proto) with the Airy
+// model, the C++ counterpart of python_server/airy.py.
+class WavesServiceImpl final : public Waves::Service {
+    public:
+        explicit WavesServiceImpl(WorkerPool& pool):
+            pool_(pool), model_() {}
+
+        Status set_parameters(ServerContext* context, const SetParameterRequest* request,
+                              SetParameterResponse* reply) override
+        {
+            std::cout << "Received parameters: " << request->parameters() << std::endl;
+            std::shared_ptr<const Airy> model;
+            try
+            {
+                model = std::make_shared<const Airy>(parse_airy_parameters(request->parameters()));
+            }
+            catch (const std::invalid_argument& e)
+            {
+                reply->set_error_message(e.what());
+                return Status(StatusCode::INVALID_ARGUMENT, e.what());
+            }
+            const PruningReport& pruning = model->pruning_report();
+            std::cout << "Spectrum lines: " << pruning.kept_lines << " (" << pruning.dropped_lines << " pruned, holding "
+                      << pruning.dropped_variance << " m^2 of " << pruning.total_variance << " m^2 of variance: elevation error below "
+                      << pruning.max_elevation_error << " m, " << std::sqrt(pruning.dropped_variance) << " m RMS)" << std::endl;
+            model_.publish(model);
+            return Status::OK;
+        }
+
+        Status elevations(ServerContext* context, const XYTGrid* request,
+                          XYZTGrid* reply) override
+        {
+            std::shared_ptr<const Airy> model;
+            const Status status = check(request->x_size(), request->y_size(), request->x_size(), model);
+            if (not(status.ok()))
+            {
+                return status;
+            }
+            *reply->mutable_x() = request->x();
+            *reply->mutable_y() = request->y();
+            reply->mutable_z()->Resize(request->x_size(), 0.0);
+            reply->set_t(request->t());
+            model->elevations(request->x().data(), request->y().data(), static_cast<size_t>(request->x_size()), request->t(),
+                              reply->mutable_z()->mutable_data(), pool_);
+            return Status::OK;
+        }
+
+        Status dynamic_pressures(ServerContext* context, const XYZTGrid* request,
+                                 DynamicPressuresResponse* reply) override
+        {
+            std::shared_ptr<const Airy> model;
+            const Status status = check(request->x_size(), request->y_size(), request->z_size(), model);
+            if (not(status.ok()))
+            {
+                return status;
+            }
+            *reply->mutable_x() = request->x();
+            *reply->mutable_y() = request->y();
+            *reply->mutable_z() = request->z();
+            reply->set_t(request->t());
+            reply->mutable_pdyn()->Resize(request->x_size(), 0.0);
+            model->dynamic_pressures(request->x().data(), request->y().data(), request->z().data(), static_cast<size_t>(request->x_size()),
+                                     request->t(), reply->mutable_pdyn()->mutable_data(), pool_);
+            return Status::OK;
+        }
+
+        Status orbital_velocities(ServerContext* context, const XYZTGrid* request,
+                                  OrbitalVelocitiesResponse* reply) override
+        {
+            std::shared_ptr<const Airy> model;
+            const Status status = check(request->x_size(), request->y_size(), request->z_size(), model);
+            if (not(status.ok()))
+            {
+                return status;
+            }
+            *reply->mutable_x() = request->x();
+            *reply->mutable_y() = request->y();
+            *reply->mutable_z() = request->z();
+            reply->set_t(request->t());
+            reply->mutable_vx()->Resize(request->x_size(), 0.0);
+            reply->mutable_vy()->Resize(request->x_size(), 0.0);
+            reply->mutable_vz()->Resize(request->x_size(), 0.0);
+            model->orbital_velocities(request->x().data(), request->y().data(), request->z().data(), static_cast<size_t>(request->x_size()),
+                                      request->t(), reply->mutable_vx()->mutable_data(), reply->mutable_vy()->mutable_data(),
+                                      reply->mutable_vz()->mutable_data(), pool_);
+            return Status::OK;
+        }
+
+        Status wave_fields(ServerContext* context, const XYZTGrid* request,
+                           WaveFieldsResponse* reply) override
+        {
+            std::shared_ptr<const Airy> model;
+            const Status status = check(request->x_size(), request->y_size(), request->z_size(), model);
+            if (not(status.ok()))
+            {
+                return status;
+            }
+            *reply->mutable_x() = request->x();
+            *reply->mutable_y() = request->y();
+            *reply->mutable_z() = request->z();
+            reply->set_t(request->t());
+            reply->mutable_eta()->Resize(request->x_size(), 0.0);
+            reply->mutable_pdyn()->Resize(request->x_size(), 0.0);
+            reply->mutable_vx()->Resize(request->x_size(), 0.0);
+            reply->mutable_vy()->Resize(request->x_size(), 0.0);
+            reply->mutable_vz()->Resize(request->x_size(), 0.0);
+            model->wave_fields(request->x().data(), request->y().data(), request->z().data(), static_cast<size_t>(request->x_size()),
+                               request->t(), reply->mutable_eta()->mutable_data(), reply->mutable_pdyn()->mutable_data(),
+                               reply->mutable_vx()->mutable_data(), reply->mutable_vy()->mutable_data(),
+                               reply->mutable_vz()->mutable_data(), pool_);
+            return Status::OK;
+        }
+
+        Status spectrum(ServerContext* context, const SpectrumRequest* request,
+                        SpectrumResponse* reply) override
+        {
+            std::shared_ptr<const Airy> model;
+            const Status status = check(0, 0, 0, model);
+            if (not(status.ok()))
+            {
+                return status;
+            }
+            // The full (omega, psi) grid: the pruning only concerns the computations
+            Spectrum* spectrum = reply->add_spectrum();
+            const size_t number_of_directions = model->psi().size();
+            for (size_t index = 0; index < model->omega().size(); ++index)
+            {
+                spectrum->add_si(model->si()[index]);
+                spectrum->add_omega(model->omega()[index]);
+                spectrum->add_k(model->k()[index]);
+                PhasesForEachFrequency* phases = spectrum->add_phase();
+                for (size_t j = 0; j < number_of_directions; ++j)
+                {
+                    phases->add_phase(model->phase()[index * number_of_directions + j]);
+                }
+            }
+            for (size_t j = 0; j < number_of_directions; ++j)
+            {
+                spectrum->add_dj(model->dj()[j]);
+                spectrum->add_psi(model->psi()[j]);
+            }
+            return Status::OK;
+        }
+
+        Status angular_frequencies_for_rao(ServerContext* context, const AngularFrequenciesRequest* request,
+                                           AngularFrequenciesResponse* reply) override
+        {
+            std::shared_ptr<const Airy> model;
+            const Status status = check(0, 0, 0, model);
+            if (not(status.ok()))
+            {
+                return status;
+            }
+            AngularFrequencies* angular_frequencies = reply->add_angular_frequencies();
+            for (const double omega : model->omega())
+            {
+                angular_frequencies->add_omegas(omega);
+            }
+            return Status::OK;
+        }
+
+        Status directions_for_rao(ServerContext* context, const DirectionsRequest* request,
+                                  DirectionsResponse* reply) override
+        {
+            std::shared_ptr<const Airy> model;
+            const Status status = check(0, 0, 0, model);
+            if (not(status.ok()))
+            {
+                return status;
+            }
+            Directions* directions = reply->add_directions();
+            for (const double psi : model->psi())
+            {
+                directions->add_psis(psi);
+            }
+            return Status::OK;
+        }
+
+    private:
+        // Gets the current model, and checks that the coordinates of the request have the same size
+        Status check(const int x_size, const int y_size, const int z_size, std::shared_ptr<const Airy>& model)
+        {
+            model = model_.get();
+            if (not(model))
+            {
+                return Status(StatusCode::FAILED_PRECONDITION, "set_parameters should be called first.");
+            }
+            if (x_size != y_size || x_size != z_size)
+            {
+                return Status(StatusCode::INVALID_ARGUMENT, "x, y (and z) should have the same size.");
+            }
+            return Status::OK;
+        }
+
+        WorkerPool& pool_;
+        PublishedPointer<const Airy> model_;  //!< Null until set_parameters succeeds. Can be replaced at any time without blocking the requests.
+};
+
+void run_server(const size_t number_of_threads);
+void run_server(const size_t number_of_threads)
+{
+    std::string server_address("0.0.0.0:50051");
+    WorkerPool pool(number_of_threads);
+    std::cout << "Elevation kernel: " << to_string(best_elevation_kernel_isa()) << " on " << pool.size() << " thread(s)" << std::endl;
+
+    WavesServiceImpl service(pool);
+    ServerBuilder builder;
+    builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
+    builder.RegisterService(&service);
+    std::unique_ptr<Server> server(builder.BuildAndStart());
+    std::cout << "Waves server listening on " << server_address << std::endl;
+    server->Wait();
+}
+
+int main(int argc, char** argv)
+{
+    args::ArgumentParser parser("Airy waves server implementing the Waves service of wave_grpc.proto.", "Enjoy.");
+    args::HelpFlag help(parser, "help", "Display this help menu", {'h', "help"});
+    args::ValueFlag<int> input_number_of_threads(parser, "threads", "Number of threads computing the values of a large request (1 by default: everything is computed on the gRPC handler thread).", {'t', "threads"});
+    try
+    {
+        parser.ParseCLI(argc, argv);
+    }
+    catch (args::Help)
+    {
+        std::cout << parser;
+        return 0;
+    }
+    catch (const args::ParseError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    catch (const args::ValidationError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "An internal error has occurred: " << e.what() << std::endl;
+        return -1;
+    }
+
+    size_t number_of_threads(1);
+    if (input_number_of_threads)
+    {
+        if (args::get(input_number_of_threads) < 1)
+        {
+            std::cerr << "The number of threads should be at least 1." << std::endl;
+            return 1;
+        }
+        number_of_threads = static_cast<size_t>(args::get(input_number_of_threads));
+    }
+
+    run_server(number_of_threads);
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <exception>
+#include "worker_pool.hh"
+
+struct WorkerPool::Loop
+{
+    Loop(const size_t n_, const size_t chunk_size_, const std::function<void(size_t, size_t)>& body_):
+        n(n_), chunk_size(chunk_size_), number_of_chunks((n_ + chunk_size_ - 1) / chunk_size_), body(body_),
+        next_chunk(0), finished_chunks(0), failed(false), mutex(), finished(), error() {}
+
+    const size_t n;
+    const size_t chunk_size;
+    const size_t number_of_chunks;
+    const std::function<void(size_t, size_t)>& body;
+    std::atomic<size_t> next_chunk;
+    std::atomic<size_t> finished_chunks;
+    std::atomic<bool> failed;       //!< The remaining chunks are skipped (but still counted as finished)
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::exception_ptr error;       //!< First exception thrown by body, rethrown by parallel_for
+};
+
+WorkerPool::WorkerPool(const size_t number_of_threads):
+    workers_(), mutex_(), has_work_(), loops_(), stopping_(false)
+{
+    for (size_t index = 1; index < number_of_threads; ++index)
+    {
+        workers_.push_back(std::thread(&WorkerPool::run_worker, this));
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    has_work_.notify_all();
+    for (std::thread& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void WorkerPool::run_chunks(Loop& loop)
+{
+    for (size_t chunk = loop.next_chunk++; chunk < loop.number_of_chunks; chunk = loop.next_chunk++)
+    {
+        const size_t begin = chunk * loop.chunk_size;
+        try
+        {
+            if (not(loop.failed))
+            {
+                loop.body(begin, std::min(begin + loop.chunk_size, loop.n));
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(loop.mutex);
+            if (not(loop.error))
+            {
+                loop.error = std::current_exception();
+            }
+            loop.failed = true;
+        }
+        if (++loop.finished_chunks == loop.number_of_chunks)
+        {
+            std::lock_guard<std::mutex> lock(loop.mutex);
+            loop.finished.notify_all();
+        }
+    }
+}
+
+void WorkerPool::remove(const std::shared_ptr<Loop>& loop)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::deque<std::shared_ptr<Loop> >::iterator it = std::find(loops_.begin(), loops_.end(), loop);
+    if (it != loops_.end())
+    {
+        loops_.erase(it);
+    }
+}
+
+void WorkerPool::run_worker()
+{
+    for (;;)
+    {
+        std::shared_ptr<Loop> loop;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            has_work_.wait(lock, [this]{return stopping_ || not(loops_.empty());});
+            if (loops_.empty())
+            {
+                return;
+            }
+            loop = loops_.front();
+        }
+        run_chunks(*loop);
+        // All the chunks of this loop have been claimed: let the workers move on to the next one
+        remove(loop);
+    }
+}
+
+void WorkerPool::parallel_for(const size_t n, const size_t chunk_size, const std::function<void(size_t, size_t)>& body)
+{
+    const size_t actual_chunk_size = std::max(chunk_size, size_t(1));
+    if (workers_.empty() || n <= actual_chunk_size)
+    {
+        if (n > 0)
+        {
+            body(0, n);
+        }
+        return;
+    }
+    const std::shared_ptr<Loop> loop = std::make_shared<Loop>(n, actual_chunk_size, body);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        loops_.push_back(loop);
+    }
+    has_work_.notify_all();
+    run_chunks(*loop);
+    remove(loop);
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->finished.wait(lock, [&loop]{return loop->finished_chunks == loop->number_of_chunks;});
+    if (loop->error)
+    {
+        std::rethrow_exception(loop->error);
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef WORKER_POOL_HH
+#define WORKER_POOL_HH
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of threads sharing the work of parallel loops.
+//
+// parallel_for splits [0, n) in chunks that are claimed one at a time through an
+// atomic cursor, by the calling thread and by any idle worker: a thread that is
+// done with its chunk takes the next unclaimed one, so the load balances itself
+// whatever the number of loops running concurrently (one per gRPC handler).
+class WorkerPool
+{
+    public:
+        // number_of_threads includes the calling thread: 1 means parallel_for runs sequentially
+        explicit WorkerPool(const size_t number_of_threads);
+        ~WorkerPool();
+
+        size_t size() const {return workers_.size() + 1;}
+
+        // Calls body(begin, end) on consecutive sub-ranges of [0, n) of at most chunk_size
+        // elements, and only returns once all of them have been processed. If body throws, the
+        // chunks not started yet are skipped and the first exception is rethrown, once no thread
+        // runs body any more.
+        void parallel_for(const size_t n, const size_t chunk_size, const std::function<void(size_t, size_t)>& body);
+
+    private:
+        struct Loop;
+        void run_worker();
+        static void run_chunks(Loop& loop);
+        void remove(const std::shared_ptr<Loop>& loop);
+
+        std::vector<std::thread> workers_;
+        std::mutex mutex_;
+        std::condition_variable has_work_;
+        std::deque<std::shared_ptr<Loop> > loops_;
+        bool stopping_;
+};
+
+#endif
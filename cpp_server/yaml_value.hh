@@ -0,0 +1,25 @@
+#ifndef YAML_VALUE_HH
+#define YAML_VALUE_HH
+
+#include <stdexcept>
+#include <string>
+#include <yaml-cpp/yaml.h>
+
+// Value of node[key], converted to T. Throws std::invalid_argument if the key is missing or cannot be converted.
+template <typename T> T get_yaml_value(const YAML::Node& node, const std::string& key)
+{
+    if (not(node[key]))
+    {
+        throw std::invalid_argument("Unable to find key '" + key + "' in the YAML.");
+    }
+    try
+    {
+        return node[key].as<T>();
+    }
+    catch (const YAML::Exception& e)
+    {
+        throw std::invalid_argument("Unable to parse key '" + key + "' in the YAML: " + e.what());
+    }
+}
+
+#endif
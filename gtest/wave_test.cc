@@ -1,7 +1,11 @@
 #include "gtest/gtest.h"
 #include <chrono>
+#include <cmath>
+#include <sstream>
+#include <thread>
 #include "wave_client.hh"
 using wave::ElevationRequest;
+using wave::ElevationRequestRepeated;
 
 class ServerDemo : public ::testing::Test
 {
@@ -9,10 +13,12 @@ class ServerDemo : public ::testing::Test
         void SetUp() override {
             port = "50051";
             ip = "server";
+            uncached_ip = "uncached";
         }
 
         std::string port;
         std::string ip;
+        std::string uncached_ip;    //!< Same server without cache: the same request twice is computed twice
 };
 
 TEST_F(ServerDemo, get_elevation_demo)
@@ -39,3 +45,734 @@ TEST_F(ServerDemo, get_elevation_demo)
         std::cout << "Request duration: " << diff.count() << " s." << std::endl;
     }
 }
+
+TEST_F(ServerDemo, repeated_elevation_does_not_depend_on_the_returned_fields)
+{
+    ElevationServiceClient elevation_service(grpc::CreateChannel(
+        uncached_ip + ":" + port, grpc::InsecureChannelCredentials()));
+
+    std::vector<double> x, y;
+    for (size_t index = 0; index < 1001; ++index)
+    {
+        x.push_back(-500.0 + 0.73 * index);
+        y.push_back(250.0 - 0.41 * index);
+    }
+    ElevationRequestRepeated request;
+    add_points_to_request_repeated(request, x, y);
+    request.set_t(12.5);
+
+    const ElevationResponseRepeated with_xy = elevation_service.get_elevation_repeated(request, true);
+    const ElevationResponseRepeated z_only = elevation_service.get_elevation_repeated(request, false);
+    ASSERT_EQ(static_cast<int>(x.size()), with_xy.z_size());
+    ASSERT_EQ(static_cast<int>(x.size()), z_only.z_size());
+    for (size_t index = 0; index < x.size(); ++index)
+    {
+        EXPECT_DOUBLE_EQ(x[index], with_xy.x(static_cast<int>(index)));
+        EXPECT_DOUBLE_EQ(y[index], with_xy.y(static_cast<int>(index)));
+        EXPECT_DOUBLE_EQ(with_xy.z(static_cast<int>(index)), z_only.z(static_cast<int>(index)));
+    }
+}
+
+TEST_F(ServerDemo, packed_elevation_matches_repeated_elevation)
+{
+    ElevationServiceClient elevation_service(grpc::CreateChannel(
+        uncached_ip + ":" + port, grpc::InsecureChannelCredentials()));
+
+    std::vector<double> x, y;
+    for (size_t index = 0; index < 257; ++index)
+    {
+        x.push_back(-50.0 + 0.37 * index);
+        y.push_back(20.0 - 0.11 * index);
+    }
+    ElevationRequestRepeated repeated_request;
+    add_points_to_request_repeated(repeated_request, x, y);
+    repeated_request.set_t(3.2);
+    ElevationRequestPacked packed_request;
+    add_points_to_request_packed(packed_request, x, y);
+    packed_request.set_t(3.2);
+
+    const ElevationResponseRepeated repeated = elevation_service.get_elevation_repeated(repeated_request, false);
+    const ElevationResponsePacked packed = elevation_service.get_elevation_packed(packed_request, true);
+    const std::vector<double> z = unpack_values(packed.z(), packed.encoding());
+    ASSERT_EQ(x, unpack_values(packed.x(), packed.encoding()));
+    ASSERT_EQ(y, unpack_values(packed.y(), packed.encoding()));
+    ASSERT_EQ(repeated.z_size(), static_cast<int>(z.size()));
+    for (size_t index = 0; index < z.size(); ++index)
+    {
+        EXPECT_DOUBLE_EQ(repeated.z(static_cast<int>(index)), z[index]);
+    }
+}
+
+TEST_F(ServerDemo, float_elevation_is_close_to_double_elevation)
+{
+    ElevationServiceClient elevation_service(grpc::CreateChannel(
+        ip + ":" + port, grpc::InsecureChannelCredentials()));
+
+    std::vector<double> x, y;
+    for (size_t index = 0; index < 1001; ++index)
+    {
+        x.push_back(-500.0 + 0.97 * index);
+        y.push_back(400.0 - 0.83 * index);
+    }
+    ElevationRequestRepeated request;
+    add_points_to_request_repeated(request, x, y);
+    // Large enough for omega.t to lose 10 bits if it were computed in single precision
+    request.set_t(10000.3);
+
+    const ElevationResponseRepeated reference = elevation_service.get_elevation_repeated(request, false);
+    const ElevationResponseRepeatedFloat single = elevation_service.get_elevation_repeated_float(request);
+    EXPECT_FLOAT_EQ(10000.3f, static_cast<float>(single.t()));
+    ASSERT_EQ(reference.z_size(), single.z_size());
+    for (int index = 0; index < single.z_size(); ++index)
+    {
+        EXPECT_NEAR(reference.z(index), single.z(index), 1e-3);
+    }
+}
+
+TEST_F(ServerDemo, session_elevations_match_repeated_elevations)
+{
+    ElevationServiceClient elevation_service(grpc::CreateChannel(
+        ip + ":" + port, grpc::InsecureChannelCredentials()));
+
+    std::vector<double> x, y, dx, dy;
+    for (size_t index = 0; index < 100; ++index)
+    {
+        x.push_back(1.5 * index);
+        y.push_back(-0.5 * index);
+        dx.push_back(2.0);
+        dy.push_back(-1.0);
+    }
+    std::unique_ptr<ElevationSessionClient> session = elevation_service.start_session(x, y);
+    std::vector<double> z;
+    for (size_t step = 0; step < 3; ++step)
+    {
+        const double t = 0.4 * step;
+        ASSERT_TRUE(session->get_elevations(t, z));
+        ElevationRequestRepeated request;
+        add_points_to_request_repeated(request, x, y);
+        request.set_t(t);
+        const ElevationResponseRepeated expected = elevation_service.get_elevation_repeated(request, false);
+        ASSERT_EQ(expected.z_size(), static_cast<int>(z.size()));
+        for (size_t index = 0; index < z.size(); ++index)
+        {
+            EXPECT_DOUBLE_EQ(expected.z(static_cast<int>(index)), z[index]);
+        }
+    }
+    ASSERT_TRUE(session->move_points(dx, dy, 5.0, z));
+    for (size_t index = 0; index < x.size(); ++index)
+    {
+        x[index] += dx[index];
+        y[index] += dy[index];
+    }
+    ElevationRequestRepeated request;
+    add_points_to_request_repeated(request, x, y);
+    request.set_t(5.0);
+    const ElevationResponseRepeated expected = elevation_service.get_elevation_repeated(request, false);
+    ASSERT_EQ(expected.z_size(), static_cast<int>(z.size()));
+    for (size_t index = 0; index < z.size(); ++index)
+    {
+        EXPECT_DOUBLE_EQ(expected.z(static_cast<int>(index)), z[index]);
+    }
+    EXPECT_TRUE(session->finish().ok());
+}
+
+TEST_F(ServerDemo, grid_elevation_matches_repeated_elevation)
+{
+    ElevationServiceClient elevation_service(grpc::CreateChannel(
+        ip + ":" + port, grpc::InsecureChannelCredentials()));
+
+    ElevationRequestGrid grid_request;
+    grid_request.set_x0(-20.0);
+    grid_request.set_y0(15.0);
+    grid_request.set_dx(1.25);
+    grid_request.set_dy(-0.5);
+    grid_request.set_nx(37);
+    grid_request.set_ny(11);
+    grid_request.set_t(7.5);
+    ElevationRequestRepeated repeated_request;
+    for (size_t j = 0; j < grid_request.ny(); ++j)
+    {
+        for (size_t i = 0; i < grid_request.nx(); ++i)
+        {
+            repeated_request.add_x(grid_request.x0() + static_cast<double>(i) * grid_request.dx());
+            repeated_request.add_y(grid_request.y0() + static_cast<double>(j) * grid_request.dy());
+        }
+    }
+    repeated_request.set_t(grid_request.t());
+
+    const ElevationResponseRepeated grid = elevation_service.get_elevation_grid(grid_request);
+    const ElevationResponseRepeated repeated = elevation_service.get_elevation_repeated(repeated_request, false);
+    ASSERT_EQ(repeated.z_size(), grid.z_size());
+    for (int index = 0; index < grid.z_size(); ++index)
+    {
+        EXPECT_NEAR(repeated.z(index), grid.z(index), 1e-12);
+    }
+}
+
+TEST_F(ServerDemo, chunked_elevation_stream_matches_one_message_per_time_step)
+{
+    ElevationServiceClient elevation_service(grpc::CreateChannel(
+        ip + ":" + port, grpc::InsecureChannelCredentials()));
+
+    std::vector<double> x, y;
+    for (size_t index = 0; index < 50; ++index)
+    {
+        x.push_back(-20.0 + 0.9 * index);
+        y.push_back(5.0 - 0.3 * index);
+    }
+    ElevationRequest request;
+    add_points_to_request(request, x, y);
+    request.set_t_start(0);
+    request.set_t_end(2);
+    request.set_dt(0.25);
+    const std::vector<ElevationResponse> one_per_step = elevation_service.get_elevations(request);
+    ASSERT_EQ(9u, one_per_step.size());
+
+    request.set_time_steps_per_message(4);
+    const std::vector<ElevationResponse> grouped = elevation_service.get_elevations(request);
+    ASSERT_EQ(3u, grouped.size());
+    size_t step = 0;
+    for (const ElevationResponse& message : grouped)
+    {
+        ASSERT_EQ(message.time_steps_size() * static_cast<int>(x.size()), message.elevation_points_size());
+        for (int index = 0; index < message.elevation_points_size(); ++index)
+        {
+            const ElevationResponse& expected = one_per_step[step + index / x.size()];
+            EXPECT_DOUBLE_EQ(expected.t(), message.time_steps(static_cast<int>(index / x.size())));
+            EXPECT_DOUBLE_EQ(expected.elevation_points(static_cast<int>(index % x.size())).z(), message.elevation_points(index).z());
+        }
+        step += message.time_steps_size();
+    }
+    EXPECT_EQ(one_per_step.size(), step);
+
+    request.set_max_points_per_message(20);
+    const std::vector<ElevationResponse> split = elevation_service.get_elevations(request);
+    ASSERT_EQ(9u * 3u, split.size());
+    for (size_t index = 0; index < split.size(); ++index)
+    {
+        const ElevationResponse& expected = one_per_step[index / 3];
+        const ElevationResponse& message = split[index];
+        EXPECT_DOUBLE_EQ(expected.t(), message.t());
+        EXPECT_EQ(20 * (index % 3), message.first_point());
+        for (int point = 0; point < message.elevation_points_size(); ++point)
+        {
+            EXPECT_DOUBLE_EQ(expected.elevation_points(static_cast<int>(message.first_point()) + point).z(), message.elevation_points(point).z());
+        }
+    }
+}
+
+TEST_F(ServerDemo, phasor_recurrence_stays_close_to_exact_elevation)
+{
+    ElevationServiceClient elevation_service(grpc::CreateChannel(
+        ip + ":" + port, grpc::InsecureChannelCredentials()));
+
+    std::vector<double> x, y;
+    for (size_t index = 0; index < 60; ++index)
+    {
+        x.push_back(-30.0 + 1.1 * index);
+        y.push_back(12.0 - 0.7 * index);
+    }
+    ElevationRequest request;
+    add_points_to_request(request, x, y);
+    request.set_t_start(0.5);
+    request.set_t_end(20.5);
+    request.set_dt(0.05);
+    const std::vector<ElevationResponse> exact = elevation_service.get_elevations(request);
+    ASSERT_EQ(401u, exact.size());
+
+    // 4 resynchronisations
+    request.set_resynchronisation_period(100);
+    const std::vector<ElevationResponse> recurrence = elevation_service.get_elevations(request);
+    ASSERT_EQ(exact.size(), recurrence.size());
+    for (size_t step = 0; step < exact.size(); ++step)
+    {
+        EXPECT_DOUBLE_EQ(exact[step].t(), recurrence[step].t());
+        ASSERT_EQ(exact[step].elevation_points_size(), recurrence[step].elevation_points_size());
+        for (int index = 0; index < exact[step].elevation_points_size(); ++index)
+        {
+            // Drift documented in the Readme
+            EXPECT_NEAR(exact[step].elevation_points(index).z(), recurrence[step].elevation_points(index).z(), 1e-13);
+        }
+    }
+}
+
+TEST_F(ServerDemo, multi_time_elevation_matches_repeated_elevation)
+{
+    ElevationServiceClient elevation_service(grpc::CreateChannel(
+        ip + ":" + port, grpc::InsecureChannelCredentials()));
+
+    std::vector<double> x, y;
+    for (size_t index = 0; index < 300; ++index)
+    {
+        x.push_back(-150.0 + 1.01 * index);
+        y.push_back(60.0 - 0.47 * index);
+    }
+    // Neither sorted nor evenly spaced
+    const std::vector<double> t{12.5, 0.0, 3.75, 3600.1, 7.0, 8.25, 1.0};
+    ElevationRequestTimes request;
+    for (size_t index = 0; index < x.size(); ++index)
+    {
+        request.add_x(x[index]);
+        request.add_y(y[index]);
+    }
+    for (const double time : t)
+    {
+        request.add_t(time);
+    }
+
+    const ElevationResponseTimes times = elevation_service.get_elevation_times(request);
+    ASSERT_EQ(x.size(), times.number_of_points());
+    ASSERT_EQ(static_cast<int>(x.size() * t.size()), times.z_size());
+    ASSERT_EQ(static_cast<int>(t.size()), times.t_size());
+    for (size_t j = 0; j < t.size(); ++j)
+    {
+        EXPECT_DOUBLE_EQ(t[j], times.t(static_cast<int>(j)));
+        ElevationRequestRepeated repeated_request;
+        add_points_to_request_repeated(repeated_request, x, y);
+        repeated_request.set_t(t[j]);
+        const ElevationResponseRepeated repeated = elevation_service.get_elevation_repeated(repeated_request, false);
+        ASSERT_EQ(static_cast<int>(x.size()), repeated.z_size());
+        for (size_t i = 0; i < x.size(); ++i)
+        {
+            EXPECT_NEAR(repeated.z(static_cast<int>(i)), times.z(static_cast<int>(j * x.size() + i)), 1e-10);
+        }
+    }
+}
+
+TEST_F(ServerDemo, concurrent_requests_at_the_same_time_get_their_own_elevations)
+{
+    // Small requests of several clients at the same t, which the server may compute together
+    const double t = 4321.125;
+    const size_t number_of_clients = 8;
+    std::vector<std::vector<double> > x(number_of_clients), y(number_of_clients);
+    std::vector<ElevationResponseRepeated> responses(number_of_clients);
+    for (size_t client = 0; client < number_of_clients; ++client)
+    {
+        for (size_t index = 0; index < 20 + 13 * client; ++index)
+        {
+            x[client].push_back(-300.0 + 75.0 * client + 0.61 * index);
+            y[client].push_back(40.0 * client - 1.3 * index);
+        }
+    }
+    std::vector<std::thread> clients;
+    for (size_t client = 0; client < number_of_clients; ++client)
+    {
+        clients.emplace_back([this, t, client, &x, &y, &responses]
+        {
+            ElevationServiceClient elevation_service(grpc::CreateChannel(
+                ip + ":" + port, grpc::InsecureChannelCredentials()));
+            ElevationRequestRepeated request;
+            add_points_to_request_repeated(request, x[client], y[client]);
+            request.set_t(t);
+            responses[client] = elevation_service.get_elevation_repeated(request, false);
+        });
+    }
+    for (std::thread& client : clients)
+    {
+        client.join();
+    }
+
+    ElevationServiceClient elevation_service(grpc::CreateChannel(
+        ip + ":" + port, grpc::InsecureChannelCredentials()));
+    for (size_t client = 0; client < number_of_clients; ++client)
+    {
+        // Not batched nor cached
+        ElevationRequestTimes request;
+        for (size_t index = 0; index < x[client].size(); ++index)
+        {
+            request.add_x(x[client][index]);
+            request.add_y(y[client][index]);
+        }
+        request.add_t(t);
+        const ElevationResponseTimes expected = elevation_service.get_elevation_times(request);
+        ASSERT_EQ(static_cast<int>(x[client].size()), responses[client].z_size());
+        ASSERT_EQ(expected.z_size(), responses[client].z_size());
+        for (int i = 0; i < expected.z_size(); ++i)
+        {
+            EXPECT_NEAR(expected.z(i), responses[client].z(i), 1e-12);
+        }
+    }
+}
+
+// Stats of method, or an empty RpcStats if it was never called
+wave::RpcStats find_rpc_stats(const wave::ServerStatsResponse& stats, const std::string& method);
+wave::RpcStats find_rpc_stats(const wave::ServerStatsResponse& stats, const std::string& method)
+{
+    for (const wave::RpcStats& rpc_stats : stats.rpcs())
+    {
+        if (rpc_stats.method() == method)
+        {
+            return rpc_stats;
+        }
+    }
+    return wave::RpcStats();
+}
+
+TEST_F(ServerDemo, server_stats_count_the_requests_served)
+{
+    ElevationServiceClient elevation_service(grpc::CreateChannel(
+        ip + ":" + port, grpc::InsecureChannelCredentials()));
+    const wave::ServerStatsResponse before = elevation_service.get_server_stats();
+
+    std::vector<double> x, y;
+    for (size_t index = 0; index < 100; ++index)
+    {
+        x.push_back(0.7 * index);
+        y.push_back(-0.3 * index);
+    }
+    ElevationRequestRepeated request;
+    add_points_to_request_repeated(request, x, y);
+    for (size_t index = 0; index < 5; ++index)
+    {
+        request.set_t(10.0 + index);
+        elevation_service.get_elevation_repeated(request, false);
+    }
+    // Rejected: too many points
+    wave::ElevationRequestGrid grid_request;
+    grid_request.set_nx(1 << 16);
+    grid_request.set_ny(1 << 16);
+    elevation_service.get_elevation_grid(grid_request);
+
+    const wave::ServerStatsResponse after = elevation_service.get_server_stats();
+    EXPECT_GE(after.uptime(), before.uptime());
+    const wave::RpcStats repeated_before = find_rpc_stats(before, "GetElevationRepeated");
+    const wave::RpcStats repeated_after = find_rpc_stats(after, "GetElevationRepeated");
+    EXPECT_GE(repeated_after.calls(), repeated_before.calls() + 5);
+    EXPECT_GE(repeated_after.messages(), repeated_before.messages() + 5);
+    EXPECT_GE(repeated_after.compute_time().count(), repeated_before.compute_time().count() + 5);
+    EXPECT_GT(repeated_after.compute_time().max(), 0);
+    EXPECT_GE(repeated_after.points().max(), 100);
+    // 100 x, y and z doubles at least
+    EXPECT_GE(repeated_after.response_bytes().max(), 3 * 100 * sizeof(double));
+    const wave::RpcStats grid_after = find_rpc_stats(after, "GetElevationGrid");
+    EXPECT_GE(grid_after.errors(), find_rpc_stats(before, "GetElevationGrid").errors() + 1);
+    EXPECT_GE(find_rpc_stats(after, "GetServerStats").calls(), uint64_t(2));
+}
+
+// Large enough to go through shared memory, the gtest client sharing the IPC namespace of the server
+TEST_F(ServerDemo, large_z_only_request_matches_multi_time_elevation)
+{
+    ElevationServiceClient elevation_service(grpc::CreateChannel(
+        ip + ":" + port, grpc::InsecureChannelCredentials()));
+
+    const double t = 271.5;
+    ElevationRequestRepeated request;
+    wave::ElevationRequestTimes times_request;
+    for (size_t index = 0; index < 3 * SHARED_MEMORY_MIN_POINTS; ++index)
+    {
+        const double x = -1000.0 + 0.21 * index;
+        const double y = 500.0 - 0.13 * index;
+        request.add_x(x);
+        request.add_y(y);
+        times_request.add_x(x);
+        times_request.add_y(y);
+    }
+    request.set_t(t);
+    times_request.add_t(t);
+    const wave::RpcStats shared_before = find_rpc_stats(elevation_service.get_server_stats(), "GetElevationShared");
+    for (size_t repetition = 0; repetition < 2; ++repetition)
+    {
+        const ElevationResponseRepeated response = elevation_service.get_elevation_repeated(request, false);
+        const wave::ElevationResponseTimes expected = elevation_service.get_elevation_times(times_request);
+        EXPECT_EQ(0, response.x_size());
+        ASSERT_EQ(request.x_size(), response.z_size());
+        ASSERT_EQ(expected.z_size(), response.z_size());
+        for (int index = 0; index < response.z_size(); ++index)
+        {
+            EXPECT_NEAR(expected.z(index), response.z(index), 1e-12);
+        }
+    }
+    const wave::RpcStats shared_after = find_rpc_stats(elevation_service.get_server_stats(), "GetElevationShared");
+    EXPECT_EQ(shared_before.calls() + 2, shared_after.calls());
+    EXPECT_EQ(shared_before.errors(), shared_after.errors());
+}
+
+TEST_F(ServerDemo, pipelined_requests_match_blocking_requests)
+{
+    const std::shared_ptr<grpc::Channel> channel = grpc::CreateChannel(ip + ":" + port, grpc::InsecureChannelCredentials());
+    ElevationServiceClient elevation_service(channel);
+    AsyncElevationServiceClient async_elevation_service(channel, 3);
+
+    std::vector<ElevationRequestRepeated> requests(10);
+    std::vector<std::future<ElevationResponseRepeated> > responses;
+    for (size_t step = 0; step < requests.size(); ++step)
+    {
+        for (size_t index = 0; index < 50; ++index)
+        {
+            requests[step].add_x(-20.0 + 0.8 * index);
+            requests[step].add_y(3.0 * step - 0.4 * index);
+        }
+        requests[step].set_t(0.25 * step);
+        // Sent at once, at most 3 at a time
+        responses.push_back(async_elevation_service.get_elevation_repeated(requests[step], false));
+    }
+    for (size_t step = 0; step < requests.size(); ++step)
+    {
+        const ElevationResponseRepeated response = responses[step].get();
+        const ElevationResponseRepeated expected = elevation_service.get_elevation_repeated(requests[step], false);
+        EXPECT_EQ(requests[step].t(), response.t());
+        ASSERT_EQ(expected.z_size(), response.z_size());
+        for (int index = 0; index < response.z_size(); ++index)
+        {
+            EXPECT_EQ(expected.z(index), response.z(index));
+        }
+    }
+    // The futures are fulfilled just before their slot is released
+    async_elevation_service.wait();
+    EXPECT_EQ(size_t(0), async_elevation_service.in_flight());
+
+    // Errors come with their status
+    wave::ElevationRequestGrid grid_request;
+    grid_request.set_nx(1 << 16);
+    grid_request.set_ny(1 << 16);
+    std::future<ElevationResponseRepeated> rejected = async_elevation_service.get_elevation_grid(grid_request);
+    try
+    {
+        rejected.get();
+        FAIL() << "The grid should have been rejected";
+    }
+    catch (const ElevationServiceError& error)
+    {
+        EXPECT_EQ(grpc::StatusCode::INVALID_ARGUMENT, error.code());
+    }
+
+    // A callback that throws does not stop the polling thread
+    async_elevation_service.start(&ElevationService::Stub::PrepareAsyncGetElevationRepeatedZ, requests[0],
+        AsyncClientResponse<ElevationResponseRepeated>::Callback([](const grpc::Status&, ElevationResponseRepeated&)
+        {
+            throw std::runtime_error("callback error");
+        }));
+    EXPECT_EQ(requests[1].t(), async_elevation_service.get_elevation_repeated(requests[1], false).get().t());
+}
+
+TEST_F(ServerDemo, snapshot_elevation_is_within_its_error_bound)
+{
+    ElevationServiceClient elevation_service(grpc::CreateChannel(
+        ip + ":" + port, grpc::InsecureChannelCredentials()));
+
+    ElevationRequestSnapshot snapshot_request;
+    ElevationRequestGrid* grid = snapshot_request.mutable_grid();
+    grid->set_x0(-64.0);
+    grid->set_y0(-32.0);
+    grid->set_dx(2.0);
+    grid->set_dy(1.0);
+    grid->set_nx(64);
+    grid->set_ny(64);
+    grid->set_t(3.0);
+    std::vector<double> x, y;
+    for (size_t index = 0; index < 50; ++index)
+    {
+        x.push_back(-64.0 + 2.5 * index);
+        y.push_back(-32.0 + 1.2 * index);
+        snapshot_request.add_x(x.back());
+        snapshot_request.add_y(y.back());
+    }
+    ElevationRequestRepeated repeated_request;
+    add_points_to_request_repeated(repeated_request, x, y);
+    repeated_request.set_t(grid->t());
+
+    const ElevationResponseSnapshot snapshot = elevation_service.get_elevation_snapshot(snapshot_request);
+    const ElevationResponseRepeated repeated = elevation_service.get_elevation_repeated(repeated_request, false);
+    ASSERT_EQ(repeated.z_size(), snapshot.z_size());
+    for (int index = 0; index < snapshot.z_size(); ++index)
+    {
+        EXPECT_LE(std::abs(repeated.z(index) - snapshot.z(index)), snapshot.error_bound());
+    }
+}
+
+// Leaves a one line spectrum on the server: the other tests compare RPCs with each other, whatever the spectrum.
+TEST_F(ServerDemo, set_wave_spectrum_replaces_the_spectrum_of_the_next_requests)
+{
+    ElevationServiceClient elevation_service(grpc::CreateChannel(
+        ip + ":" + port, grpc::InsecureChannelCredentials()));
+
+    const std::vector<double> x{-10, 0, 3.5, 42};
+    const std::vector<double> y{5, 0, -7.25, 1};
+    ElevationRequestRepeated request;
+    add_points_to_request_repeated(request, x, y);
+    request.set_t(4.5);
+    // Cached with the current spectrum: must not be returned once the spectrum has changed
+    elevation_service.get_elevation_repeated(request, false);
+
+    const double a = 1.5, omega = 0.8, psi = 0.3, k = omega * omega / 9.81, phase = 2.1;
+    SetWaveSpectrumRequest yaml_request;
+    std::stringstream yaml;
+    yaml.precision(17);
+    yaml << "{a: [" << a << "], omega: [" << omega << "], psi: [" << psi << "], k: [" << k << "], phase: [" << phase << "]}";
+    yaml_request.set_yaml(yaml.str());
+    EXPECT_EQ(1u, elevation_service.set_wave_spectrum(yaml_request).number_of_lines());
+    const ElevationResponseRepeated one_line = elevation_service.get_elevation_repeated(request, false);
+    ASSERT_EQ(static_cast<int>(x.size()), one_line.z_size());
+    for (size_t index = 0; index < x.size(); ++index)
+    {
+        const double expected = -a * std::sin(k * (x[index] * std::cos(psi) + y[index] * std::sin(psi)) - omega * request.t() + phase);
+        EXPECT_NEAR(expected, one_line.z(static_cast<int>(index)), 1e-12);
+    }
+
+    SetWaveSpectrumRequest lines_request;
+    wave::WaveSpectrumLine* line = lines_request.mutable_lines()->add_spectrum_lines();
+    line->set_a(2 * a);
+    line->set_omega(omega);
+    line->set_psi(psi);
+    line->set_k(k);
+    line->set_phase(phase);
+    EXPECT_EQ(1u, elevation_service.set_wave_spectrum(lines_request).number_of_lines());
+    const ElevationResponseRepeated twice = elevation_service.get_elevation_repeated(request, false);
+    ASSERT_EQ(one_line.z_size(), twice.z_size());
+    for (int index = 0; index < twice.z_size(); ++index)
+    {
+        EXPECT_NEAR(2 * one_line.z(index), twice.z(index), 1e-12);
+    }
+}
+
+TEST_F(ServerDemo, pruned_spectrum_stays_within_the_reported_error)
+{
+    ElevationServiceClient elevation_service(grpc::CreateChannel(
+        ip + ":" + port, grpc::InsecureChannelCredentials()));
+
+    const std::string yaml = "{a: [1.5, 1e-5, 0.8, 1e-9], omega: [0.6, 0.7, 0.8, 0.9], psi: [0, 1, 2, 3],"
+                             " k: [0.0367, 0.0499, 0.0652, 0.0826], phase: [0.1, 0.2, 0.3, 0.4]}";
+    ElevationRequestRepeated request;
+    add_points_to_request_repeated(request, {-12, 0, 7.5, 30}, {4, 0, -2, 11});
+    request.set_t(2.5);
+
+    SetWaveSpectrumRequest full_request;
+    full_request.set_yaml(yaml);
+    EXPECT_EQ(4u, elevation_service.set_wave_spectrum(full_request).number_of_lines());
+    const ElevationResponseRepeated full = elevation_service.get_elevation_repeated(request, false);
+
+    SetWaveSpectrumRequest pruned_request;
+    pruned_request.set_yaml(yaml);
+    pruned_request.set_pruning(1e-6);
+    const SetWaveSpectrumResponse pruning = elevation_service.set_wave_spectrum(pruned_request);
+    EXPECT_EQ(2u, pruning.number_of_lines());
+    EXPECT_EQ(2u, pruning.number_of_pruned_lines());
+    EXPECT_NEAR(1e-5 + 1e-9, pruning.max_elevation_error(), 1e-15);
+    const ElevationResponseRepeated pruned = elevation_service.get_elevation_repeated(request, false);
+    ASSERT_EQ(full.z_size(), pruned.z_size());
+    for (int index = 0; index < pruned.z_size(); ++index)
+    {
+        EXPECT_LE(std::abs(full.z(index) - pruned.z(index)), pruning.max_elevation_error() + 1e-12);
+    }
+
+    // Negative amplitudes (phase shifted by pi) are as strong as positive ones
+    pruned_request.set_yaml("{a: [1.5, -1e-5, -0.8, 1e-9], omega: [0.6, 0.7, 0.8, 0.9], psi: [0, 1, 2, 3],"
+                            " k: [0.0367, 0.0499, 0.0652, 0.0826], phase: [0.1, 0.2, 0.3, 0.4]}");
+    const SetWaveSpectrumResponse negative = elevation_service.set_wave_spectrum(pruned_request);
+    EXPECT_EQ(2u, negative.number_of_lines());
+    EXPECT_EQ(2u, negative.number_of_pruned_lines());
+    EXPECT_NEAR(1e-5 + 1e-9, negative.max_elevation_error(), 1e-15);
+}
+
+TEST_F(ServerDemo, cache_hits_repeated_requests_and_misses_after_a_spectrum_change)
+{
+    ElevationServiceClient elevation_service(grpc::CreateChannel(
+        ip + ":" + port, grpc::InsecureChannelCredentials()));
+
+    std::vector<double> x, y;
+    for (size_t index = 0; index < 64; ++index)
+    {
+        x.push_back(-8.0 + 0.25 * index);
+        y.push_back(3.0 + 0.5 * index);
+    }
+    ElevationRequestRepeated request;
+    add_points_to_request_repeated(request, x, y);
+    // Not requested by any other test
+    request.set_t(8765.5);
+
+    const wave::ServerStatsResponse before = elevation_service.get_server_stats();
+    const ElevationResponseRepeated first = elevation_service.get_elevation_repeated(request, false);
+    const wave::ServerStatsResponse after_first = elevation_service.get_server_stats();
+    EXPECT_EQ(before.cache_misses() + 1, after_first.cache_misses());
+    EXPECT_EQ(before.cache_hits(), after_first.cache_hits());
+    EXPECT_GT(after_first.cache_size_in_bytes(), uint64_t(0));
+    const ElevationResponseRepeated second = elevation_service.get_elevation_repeated(request, false);
+    const wave::ServerStatsResponse after_second = elevation_service.get_server_stats();
+    EXPECT_EQ(after_first.cache_misses(), after_second.cache_misses());
+    EXPECT_EQ(after_first.cache_hits() + 1, after_second.cache_hits());
+    ASSERT_EQ(first.z_size(), second.z_size());
+    for (int index = 0; index < first.z_size(); ++index)
+    {
+        EXPECT_EQ(first.z(index), second.z(index));
+    }
+
+    const double a = 0.75, omega = 1.1, psi = -0.4, k = omega * omega / 9.81, phase = 0.3;
+    SetWaveSpectrumRequest spectrum_request;
+    std::stringstream yaml;
+    yaml.precision(17);
+    yaml << "{a: [" << a << "], omega: [" << omega << "], psi: [" << psi << "], k: [" << k << "], phase: [" << phase << "]}";
+    spectrum_request.set_yaml(yaml.str());
+    EXPECT_EQ(1u, elevation_service.set_wave_spectrum(spectrum_request).number_of_lines());
+    const wave::ServerStatsResponse after_change = elevation_service.get_server_stats();
+    EXPECT_EQ(uint64_t(0), after_change.cache_size_in_bytes());
+    const ElevationResponseRepeated third = elevation_service.get_elevation_repeated(request, false);
+    const wave::ServerStatsResponse after_third = elevation_service.get_server_stats();
+    EXPECT_EQ(after_change.cache_misses() + 1, after_third.cache_misses());
+    EXPECT_EQ(after_change.cache_hits(), after_third.cache_hits());
+    ASSERT_EQ(static_cast<int>(x.size()), third.z_size());
+    for (size_t index = 0; index < x.size(); ++index)
+    {
+        const double expected = -a * std::sin(k * (x[index] * std::cos(psi) + y[index] * std::sin(psi)) - omega * request.t() + phase);
+        EXPECT_NEAR(expected, third.z(static_cast<int>(index)), 1e-12);
+    }
+}
+
+TEST_F(ServerDemo, spectrum_files_outside_of_the_spectrum_directory_are_rejected)
+{
+    // The gtest server has no spectrum directory: no file can be mapped, and the errors do not tell whether it exists
+    std::unique_ptr<ElevationService::Stub> stub(ElevationService::NewStub(grpc::CreateChannel(
+        ip + ":" + port, grpc::InsecureChannelCredentials())));
+    for (const std::string file : {"/etc/hostname", "../etc/hostname", "a/../../etc/hostname", "spectrum.wsp"})
+    {
+        grpc::ClientContext context;
+        SetWaveSpectrumRequest request;
+        request.set_file(file);
+        SetWaveSpectrumResponse reply;
+        const grpc::Status status = stub->SetWaveSpectrum(&context, request, &reply);
+        EXPECT_EQ(grpc::StatusCode::INVALID_ARGUMENT, status.error_code()) << file;
+        EXPECT_EQ(std::string::npos, status.error_message().find("No such file")) << status.error_message();
+    }
+}
+
+TEST_F(ServerDemo, points_with_a_missing_coordinate_are_rejected)
+{
+    std::unique_ptr<ElevationService::Stub> stub(ElevationService::NewStub(grpc::CreateChannel(
+        ip + ":" + port, grpc::InsecureChannelCredentials())));
+    ElevationRequestRepeated request;
+    add_points_to_request_repeated(request, {1, 2}, {4, 5});
+    request.add_x(3);
+    request.set_t(1.5);
+    grpc::ClientContext repeated_context, z_context, times_context;
+    ElevationResponseRepeated reply;
+    EXPECT_EQ(grpc::StatusCode::INVALID_ARGUMENT, stub->GetElevationRepeated(&repeated_context, request, &reply).error_code());
+    EXPECT_EQ(grpc::StatusCode::INVALID_ARGUMENT, stub->GetElevationRepeatedZ(&z_context, request, &reply).error_code());
+
+    wave::ElevationRequestTimes times_request;
+    *times_request.mutable_x() = request.x();
+    *times_request.mutable_y() = request.y();
+    times_request.add_t(1.5);
+    wave::ElevationResponseTimes times_reply;
+    EXPECT_EQ(grpc::StatusCode::INVALID_ARGUMENT, stub->GetElevationTimes(&times_context, times_request, &times_reply).error_code());
+}
+
+TEST_F(ServerDemo, too_many_time_steps_per_message_are_rejected)
+{
+    std::unique_ptr<ElevationService::Stub> stub(ElevationService::NewStub(grpc::CreateChannel(
+        ip + ":" + port, grpc::InsecureChannelCredentials())));
+    ElevationRequest request;
+    for (size_t index = 0; index < 1000; ++index)
+    {
+        wave::Point* point = request.add_points();
+        point->set_x(0.5 * index);
+        point->set_y(-0.25 * index);
+    }
+    request.set_t_start(0);
+    request.set_t_end(10000);
+    request.set_dt(0.1);
+    request.set_time_steps_per_message(100000);
+    grpc::ClientContext context;
+    std::unique_ptr<grpc::ClientReader<wave::ElevationResponse> > reader(stub->GetElevations(&context, request));
+    wave::ElevationResponse response;
+    EXPECT_FALSE(reader->Read(&response));
+    EXPECT_EQ(grpc::StatusCode::INVALID_ARGUMENT, reader->Finish().error_code());
+}
@@ -0,0 +1,146 @@
+#include "gtest/gtest.h"
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+#include "wave_grpc.grpc.pb.h"
+
+// Tests of waves_server, the C++ implementation of the Waves service (wave_grpc.proto)
+class WavesServerDemo : public ::testing::Test
+{
+    protected:
+        void SetUp() override {
+            port = "50051";
+            ip = "waves";
+            waves = Waves::NewStub(grpc::CreateChannel(ip + ":" + port, grpc::InsecureChannelCredentials()));
+        }
+
+        grpc::Status set_parameters(const std::string& parameters, SetParameterResponse& reply)
+        {
+            grpc::ClientContext context;
+            SetParameterRequest request;
+            request.set_parameters(parameters);
+            return waves->set_parameters(&context, request, &reply);
+        }
+
+        std::string port;
+        std::string ip;
+        std::unique_ptr<Waves::Stub> waves;
+};
+
+TEST_F(WavesServerDemo, too_many_spectrum_lines_are_rejected)
+{
+    SetParameterResponse reply;
+    const grpc::Status rejected = set_parameters("{waves propagating to: 90, Hs: 5, Tp: 15, gamma: 1.2, omega: [0.5, 1.0],"
+                                                 " spreading: {type: cos2s, s: 10, directions: 100000000}}", reply);
+    EXPECT_EQ(grpc::StatusCode::INVALID_ARGUMENT, rejected.error_code());
+    EXPECT_FALSE(reply.error_message().empty());
+
+    const grpc::Status accepted = set_parameters("{waves propagating to: 90, Hs: 5, Tp: 15, gamma: 1.2, omega: [0.5, 1.0],"
+                                                 " spreading: {type: cos2s, s: 10, directions: 36}}", reply);
+    EXPECT_TRUE(accepted.ok()) << accepted.error_message();
+    grpc::ClientContext context;
+    DirectionsResponse directions;
+    ASSERT_TRUE(waves->directions_for_rao(&context, DirectionsRequest(), &directions).ok());
+    ASSERT_EQ(1, directions.directions_size());
+    EXPECT_EQ(36, directions.directions(0).psis_size());
+}
+
+// Formulas of python_server/airy.py, for a long-crested sea: with theta = k.(x.cos(psi) + y.sin(psi)) - omega.t + phase
+// and f = exp(-k.z) (z downwards), eta = -sum(a.sin(theta)), pdyn = -rho.g.sum(a.f.sin(theta)), vx = sum(a.k/omega.f.sin(theta)).cos(psi),
+// vy = sum(a.k/omega.f.sin(theta)).sin(psi) and vz = sum(a.k/omega.f.cos(theta)), pdyn and v being zero above the surface (z < eta).
+TEST_F(WavesServerDemo, wave_fields_match_the_airy_formulas_below_and_above_the_surface)
+{
+    SetParameterResponse parameters;
+    ASSERT_TRUE(set_parameters("{waves propagating to: 30, Hs: 3, Tp: 9, gamma: 1.5, omega: [0.5, 0.7, 0.9], seed: 7}", parameters).ok());
+    grpc::ClientContext spectrum_context;
+    SpectrumResponse spectrum_response;
+    ASSERT_TRUE(waves->spectrum(&spectrum_context, SpectrumRequest(), &spectrum_response).ok());
+    ASSERT_EQ(1, spectrum_response.spectrum_size());
+    const Spectrum& spectrum = spectrum_response.spectrum(0);
+    ASSERT_EQ(3, spectrum.omega_size());
+    ASSERT_EQ(1, spectrum.psi_size());
+    const double psi = spectrum.psi(0);
+    const double domega = 0.2;  // Evenly spaced omega
+
+    const double t = 12.25;
+    const std::vector<double> x{-40, 0, 17.5, 63};
+    const std::vector<double> y{5, 0, -22, 8.5};
+    XYTGrid surface_request;
+    for (size_t index = 0; index < x.size(); ++index)
+    {
+        surface_request.add_x(x[index]);
+        surface_request.add_y(y[index]);
+    }
+    surface_request.set_t(t);
+    grpc::ClientContext surface_context;
+    XYZTGrid surface;
+    ASSERT_TRUE(waves->elevations(&surface_context, surface_request, &surface).ok());
+    ASSERT_EQ(static_cast<int>(x.size()), surface.z_size());
+
+    // Each point 1 m above the surface, then 2 m and 10 m below it
+    const std::vector<double> depths{-1, 2, 10};
+    XYZTGrid request;
+    for (const double depth : depths)
+    {
+        for (size_t index = 0; index < x.size(); ++index)
+        {
+            request.add_x(x[index]);
+            request.add_y(y[index]);
+            request.add_z(surface.z(static_cast<int>(index)) + depth);
+        }
+    }
+    request.set_t(t);
+    grpc::ClientContext fields_context, pressures_context, velocities_context;
+    WaveFieldsResponse fields;
+    DynamicPressuresResponse pressures;
+    OrbitalVelocitiesResponse velocities;
+    ASSERT_TRUE(waves->wave_fields(&fields_context, request, &fields).ok());
+    ASSERT_TRUE(waves->dynamic_pressures(&pressures_context, request, &pressures).ok());
+    ASSERT_TRUE(waves->orbital_velocities(&velocities_context, request, &velocities).ok());
+    ASSERT_EQ(request.z_size(), fields.eta_size());
+    ASSERT_EQ(request.z_size(), pressures.pdyn_size());
+    ASSERT_EQ(request.z_size(), velocities.vz_size());
+
+    for (int index = 0; index < request.z_size(); ++index)
+    {
+        double eta = 0, pdyn = 0, vx = 0, vy = 0, vz = 0;
+        for (int line = 0; line < spectrum.omega_size(); ++line)
+        {
+            const double a = std::sqrt(2 * spectrum.si(line) * domega);
+            const double k = spectrum.k(line);
+            const double omega = spectrum.omega(line);
+            const double theta = k * (request.x(index) * std::cos(psi) + request.y(index) * std::sin(psi)) - omega * t
+                                 + spectrum.phase(line).phase(0);
+            const double f = std::exp(-k * request.z(index));
+            eta -= a * std::sin(theta);
+            pdyn -= 1000 * 9.81 * a * f * std::sin(theta);
+            vx += a * k / omega * f * std::sin(theta) * std::cos(psi);
+            vy += a * k / omega * f * std::sin(theta) * std::sin(psi);
+            vz += a * k / omega * f * std::cos(theta);
+        }
+        EXPECT_NEAR(eta, fields.eta(index), 1e-10);
+        EXPECT_NEAR(surface.z(static_cast<int>(index % x.size())), fields.eta(index), 1e-10);
+        if (depths[static_cast<size_t>(index) / x.size()] < 0)
+        {
+            EXPECT_EQ(0, fields.pdyn(index));
+            EXPECT_EQ(0, fields.vx(index));
+            EXPECT_EQ(0, fields.vy(index));
+            EXPECT_EQ(0, fields.vz(index));
+        }
+        else
+        {
+            EXPECT_NE(0, fields.pdyn(index));
+            EXPECT_NEAR(pdyn, fields.pdyn(index), 1e-6);
+            EXPECT_NEAR(vx, fields.vx(index), 1e-10);
+            EXPECT_NEAR(vy, fields.vy(index), 1e-10);
+            EXPECT_NEAR(vz, fields.vz(index), 1e-10);
+        }
+        // The single pass gives the same values as the separate RPCs
+        EXPECT_DOUBLE_EQ(pressures.pdyn(index), fields.pdyn(index));
+        EXPECT_DOUBLE_EQ(velocities.vx(index), fields.vx(index));
+        EXPECT_DOUBLE_EQ(velocities.vy(index), fields.vy(index));
+        EXPECT_DOUBLE_EQ(velocities.vz(index), fields.vz(index));
+    }
+}